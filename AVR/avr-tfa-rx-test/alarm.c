@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel threshold alarms.
+//
+// Each reading of the channel sensor is checked against low and high limits
+// of temperature and humidity. Alarm condition is raised when the value gets
+// out of limit and cleared when it returns inside by hysteresis, so noise
+// around the limit does not toggle it. New state is accepted only after
+// debounce consecutive readings agree on it, so single misread reading
+// (there is no CRC) does not raise false alarm. Alarm latency is the
+// transmission itself (or early accept, see tfa.c).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "main.h"
+#include "tfa.h"
+#include "alarm.h"
+
+// initialize alarm (disabled)
+void alarm_init(TAlarm *alm)
+{
+	alm->flags = 0;
+	alm->count = 0;
+	alm->pending = 0;
+	alm->state = 0;
+}
+
+// enable alarm with limits t_low, t_high [0.1 degC], rh_low, rh_high [%], hysteresis t_hyst [0.1 degC], rh_hyst [%] and debounce readings
+void alarm_setup(TAlarm *alm, int16_t t_low, int16_t t_high, uint8_t rh_low, uint8_t rh_high, uint8_t t_hyst, uint8_t rh_hyst, uint8_t debounce)
+{
+	alm->t_low = t_low;
+	alm->t_high = t_high;
+	alm->rh_low = rh_low;
+	alm->rh_high = rh_high;
+	alm->t_hyst = t_hyst;
+	alm->rh_hyst = rh_hyst;
+	alm->debounce = debounce;
+	alm->count = 0;
+	alm->pending = 0;
+	alm->state = 0;
+	alm->flags = ALM_ON;
+}
+
+// check limit with hysteresis: value out of limit (sign 1 for high, -1 for low limit) for given current state
+static uint8_t alarm_limit(int16_t value, int16_t limit, int8_t sign, uint8_t hyst, uint8_t active)
+{
+	if(active)
+		return(sign*(value - limit) > -(int16_t)hyst);
+	return(sign*(value - limit) > 0);
+}
+
+// check sensor data, returns alarm state bits which changed
+uint8_t alarm_check(TAlarm *alm, TSensor *sensor)
+{
+	if(!(alm->flags & ALM_ON))
+		return(0);
+
+	int16_t temp = sensor->temp;
+	uint8_t state = 0;
+	if(alarm_limit(temp,alm->t_low,-1,alm->t_hyst,alm->state & ALM_T_LOW))
+		state |= ALM_T_LOW;
+	if(alarm_limit(temp,alm->t_high,1,alm->t_hyst,alm->state & ALM_T_HIGH))
+		state |= ALM_T_HIGH;
+	if(alarm_limit(sensor->rh,alm->rh_low,-1,alm->rh_hyst,alm->state & ALM_RH_LOW))
+		state |= ALM_RH_LOW;
+	if(alarm_limit(sensor->rh,alm->rh_high,1,alm->rh_hyst,alm->state & ALM_RH_HIGH))
+		state |= ALM_RH_HIGH;
+
+	if(state == alm->state)
+	{
+		// no change pending
+		alm->count = 0;
+		return(0);
+	}
+	if(state != alm->pending || !alm->count)
+	{
+		// other new state: start counting again
+		alm->pending = state;
+		alm->count = 0;
+	}
+	if(++alm->count < alm->debounce)
+		return(0);
+
+	// debounced: accept new state
+	uint8_t change = state ^ alm->state;
+	alm->state = state;
+	alm->count = 0;
+	return(change);
+}
+
+// get alarm state bits of all alarms (nonzero if any is active)
+uint8_t alarm_active(TAlarm *alms, uint8_t count)
+{
+	uint8_t state = 0;
+	for(uint8_t k = 0;k < count;k++)
+		state |= alms[k].state;
+	return(state);
+}
+
+// update alarm output pin: high while any alarm is active (call after every change of alarm state or setup)
+void alarm_output(TAlarm *alms, uint8_t count)
+{
+	if(alarm_active(alms,count))
+	{
+		sbi(ALARM_PORT,ALARM);
+	}
+	else
+	{
+		cbi(ALARM_PORT,ALARM);
+	}
+}
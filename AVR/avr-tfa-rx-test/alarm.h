@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel threshold alarms.
+// See alarm.c for details.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include <stdint.h>
+
+#include "tfa.h"
+
+#define ALM_ON (1<<0) /* alarm enabled */
+
+// alarm state bits
+#define ALM_T_LOW (1<<0) /* temperature below low limit */
+#define ALM_T_HIGH (1<<1) /* temperature above high limit */
+#define ALM_RH_LOW (1<<2) /* humidity below low limit */
+#define ALM_RH_HIGH (1<<3) /* humidity above high limit */
+
+#define ALM_DEBOUNCE_MAX 15 /* max debounce readings */
+
+typedef struct{
+	uint8_t flags; /* control flags */
+	int16_t t_low; /* temperature limits [0.1 degC] */
+	int16_t t_high;
+	uint8_t rh_low; /* humidity limits [%] */
+	uint8_t rh_high;
+	uint8_t t_hyst; /* temperature hysteresis [0.1 degC] */
+	uint8_t rh_hyst; /* humidity hysteresis [%] */
+	uint8_t debounce; /* consecutive readings to change state */
+	uint8_t pending; /* pending new alarm state bits */
+	uint8_t count; /* consecutive readings agreeing on pending state */
+	uint8_t state; /* alarm state bits */
+}TAlarm;
+
+
+// --- functions:
+void alarm_init(TAlarm *alm);
+void alarm_setup(TAlarm *alm, int16_t t_low, int16_t t_high, uint8_t rh_low, uint8_t rh_high, uint8_t t_hyst, uint8_t rh_hyst, uint8_t debounce);
+uint8_t alarm_check(TAlarm *alm, TSensor *sensor);
+uint8_t alarm_active(TAlarm *alms, uint8_t count);
+void alarm_output(TAlarm *alms, uint8_t count);
+
+
+#endif
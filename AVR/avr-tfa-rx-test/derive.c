@@ -0,0 +1,222 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains derived humidity quantities of sensor readings.
+//
+// Dew point is solved from Magnus formula gamma = ln(RH/100) + b*T/(c + T),
+// Td = c*gamma/(b - gamma), absolute humidity is saturation absolute
+// humidity at T times RH/100 and heat index is Rothfusz regression (NWS,
+// Celsius coefficients) for warm humid air, otherwise the temperature itself.
+// There is no logf()/expf() on the receiver: both terms of gamma and the
+// saturation humidity are fixed-point tables in flash (1 degC steps of T
+// interpolated linearly, RH is integer anyway), the rest is 32-bit integer
+// arithmetic with one division. Tables were generated from the formulas
+// above, host/tfa_derive checks them against libm over the whole range
+// (errors within 0.08 degC and 0.04 g/m3 incl. rounding). Cycles of table and float libm
+// implementations on the receiver are measured by DERIVE_BENCH build.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#ifdef __AVR__
+	#include <avr/io.h>
+	#include <avr/pgmspace.h>
+#else
+	// host build (tables in plain memory)
+	#define PROGMEM
+	#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#endif
+
+#include "tfa.h"
+#include "derive.h"
+
+// Magnus exponent b*T/(c + T) at DER_T_MIN to DER_T_MAX [2^-DER_Q]
+static const int16_t der_magnus[101] PROGMEM = {
+	-14213,-13789,-13370,-12955,-12544,-12137,-11734,-11335,-10939,-10547,
+	-10159,-9775,-9394,-9016,-8642,-8272,-7905,-7541,-7181,-6823,
+	-6469,-6118,-5771,-5426,-5084,-4746,-4410,-4077,-3747,-3420,
+	-3096,-2774,-2456,-2140,-1826,-1515,-1207,-902,-599,-298,
+	0,296,589,880,1168,1454,1738,2020,2299,2576,
+	2851,3124,3395,3663,3930,4194,4456,4717,4975,5231,
+	5486,5738,5989,6238,6484,6729,6973,7214,7454,7691,
+	7927,8162,8394,8625,8855,9082,9308,9533,9756,9977,
+	10197,10415,10631,10846,11060,11272,11483,11692,11900,12106,
+	12311,12514,12717,12917,13117,13315,13512,13707,13901,14094,
+	14286
+};
+// saturation absolute humidity 6.112*exp(b*T/(c + T))*216.74/(273.15 + T) at DER_T_MIN to DER_T_MAX [0.01 g/m3]
+static const int16_t der_ahs[101] PROGMEM = {
+	18,20,22,24,26,29,32,35,38,42,
+	46,50,55,60,65,71,77,84,91,99,
+	108,117,127,138,149,161,174,188,203,219,
+	236,255,274,295,317,341,367,393,422,453,
+	485,519,556,595,636,679,725,774,826,881,
+	938,1000,1064,1132,1204,1280,1360,1444,1533,1626,
+	1725,1828,1937,2051,2171,2297,2430,2568,2714,2867,
+	3027,3195,3370,3554,3747,3948,4158,4378,4608,4848,
+	5099,5361,5634,5919,6216,6526,6849,7185,7536,7900,
+	8280,8675,9086,9513,9957,10419,10898,11396,11913,12450,
+	13007
+};
+// ln(RH/100) for RH 1 to 100 % [2^-DER_Q]
+static const int16_t der_ln_rh[100] PROGMEM = {
+	-18863,-16024,-14363,-13185,-12271,-11524,-10892,-10345,-9863,-9431,
+	-9041,-8685,-8357,-8053,-7771,-7506,-7258,-7024,-6802,-6592,
+	-6392,-6202,-6020,-5845,-5678,-5518,-5363,-5214,-5070,-4931,
+	-4797,-4667,-4541,-4419,-4300,-4185,-4072,-3963,-3857,-3753,
+	-3652,-3553,-3457,-3363,-3271,-3181,-3093,-3006,-2922,-2839,
+	-2758,-2678,-2600,-2524,-2449,-2375,-2302,-2231,-2161,-2092,
+	-2025,-1958,-1892,-1828,-1764,-1702,-1640,-1580,-1520,-1461,
+	-1403,-1346,-1289,-1233,-1178,-1124,-1071,-1018,-966,-914,
+	-863,-813,-763,-714,-666,-618,-570,-524,-477,-432,
+	-386,-342,-297,-253,-210,-167,-125,-83,-41,0
+};
+
+// integer division rounded to nearest (den > 0)
+static int32_t der_rdiv(int32_t num, int32_t den)
+{
+	if(num < 0)
+		return(-((-num + den/2)/den));
+	return((num + den/2)/den);
+}
+
+// clamp temperature [0.1 degC] to tables range
+static int16_t der_clamp(int16_t temp)
+{
+	if(temp < DER_T_MIN*10)
+		return(DER_T_MIN*10);
+	if(temp > DER_T_MAX*10)
+		return(DER_T_MAX*10);
+	return(temp);
+}
+
+// interpolate temperature table at temp [0.1 degC]
+static int16_t der_interp(const int16_t *tab, int16_t temp)
+{
+	uint16_t pos = der_clamp(temp) - DER_T_MIN*10;
+	uint8_t k = pos/10;
+	uint8_t frac = pos%10;
+	int16_t a = pgm_read_word(&tab[k]);
+	if(!frac)
+		return(a);
+	int16_t b = pgm_read_word(&tab[k + 1]);
+	return(a + der_rdiv((int32_t)(b - a)*frac,10));
+}
+
+// dew point [0.1 degC] of temperature temp [0.1 degC] and humidity rh [%]
+int16_t derive_dew(int16_t temp, uint8_t rh)
+{
+	if(rh < 1)
+		rh = 1;
+	else if(rh > 100)
+		rh = 100;
+	int32_t gamma = (int16_t)pgm_read_word(&der_ln_rh[rh - 1]) + der_interp(der_magnus,temp);
+	// Td = c*gamma/(b - gamma) in fixed-point
+	return(der_rdiv((int32_t)(100.0*DER_C)*gamma,(int32_t)(10.0*DER_B*(1ul<<DER_Q)) - 10*gamma));
+}
+
+// absolute humidity [0.01 g/m3] of temperature temp [0.1 degC] and humidity rh [%]
+uint16_t derive_ah(int16_t temp, uint8_t rh)
+{
+	if(rh > 100)
+		rh = 100;
+	return(der_rdiv((int32_t)der_interp(der_ahs,temp)*rh,100));
+}
+
+// heat index [0.1 degC] of temperature temp [0.1 degC] and humidity rh [%]
+int16_t derive_hi(int16_t temp, uint8_t rh)
+{
+	if(temp < DER_HI_T_MIN || rh < DER_HI_RH_MIN)
+		return(temp);
+	if(rh > 100)
+		rh = 100;
+	int32_t t = der_clamp(temp);
+	int32_t t2 = t*t/10;
+	// HI = c1 + c2*T + c5*T^2 + RH*(c3 + c4*T + c7*T^2) + RH^2*(c6 + c8*T + c9*T^2), parts scaled to fit 32-bit
+	int32_t p0 = -878 + t*161139/10000 - t2*12308/100000; /* [0.01 degC] */
+	int32_t p1 = 233855 - t*146116/100 + t2*22117/1000; /* [1e-5 degC/%] */
+	int32_t p2 = (-164248 + t*72546/100 - t*t*3582/10000)/10; /* [1e-6 degC/%^2] */
+	int32_t hi = p0 + der_rdiv(p1*rh,1000) + der_rdiv(p2*rh*rh,10000);
+	return(der_rdiv(hi,10));
+}
+
+// fill derived quantities of sensor data
+void derive(TSensor *sensor)
+{
+	sensor->dew = derive_dew(sensor->temp,sensor->rh);
+	sensor->ah = derive_ah(sensor->temp,sensor->rh);
+	sensor->hi = derive_hi(sensor->temp,sensor->rh);
+}
+
+
+#if DERIVE_BENCH
+#include <math.h>
+#include <util/atomic.h>
+
+// reference float libm implementation of derive()
+static void derive_float(TSensor *sensor)
+{
+	float temp = 0.1f*sensor->temp;
+	float rh = sensor->rh;
+	float g = DER_B*temp/(DER_C + temp);
+	float gamma = logf(rh/100.0f) + g;
+	sensor->dew = lroundf(10.0f*DER_C*gamma/(DER_B - gamma));
+	sensor->ah = lroundf(100.0f*6.112f*expf(g)*rh*2.1674f/(273.15f + temp));
+	if(temp < 0.1f*DER_HI_T_MIN || rh < DER_HI_RH_MIN)
+		sensor->hi = lroundf(10.0f*temp);
+	else
+		sensor->hi = lroundf(10.0f*(-8.78469475556f + 1.61139411f*temp + 2.33854883889f*rh - 0.14611605f*temp*rh - 0.012308094f*temp*temp
+			- 0.0164248277778f*rh*rh + 2.211732e-3f*temp*temp*rh + 7.2546e-4f*temp*rh*rh - 3.582e-6f*temp*temp*rh*rh));
+}
+
+// measure cycles of table (derive) and float libm implementation: best of DER_BENCH_RUNS calls per reading,
+// averaged over readings (timer 1 at XCLK/1, each timed call runs with interrupts disabled, so tick ISR time
+// is not counted; ticks are lost meanwhile)
+void derive_bench(uint16_t *table, uint16_t *flt)
+{
+	static const int16_t temps[] = {-250,-52,0,87,215,318,452};
+	static const uint8_t rhs[] = {15,38,57,76,94};
+	#define DER_BENCH_RUNS 4
+	uint8_t tccr = TCCR1B;
+	TCCR1B = (1<<CS10);
+	uint32_t sum[2] = {0,0};
+	for(uint8_t k = 0;k < sizeof(temps)/sizeof(temps[0]);k++)
+	{
+		for(uint8_t m = 0;m < sizeof(rhs);m++)
+		{
+			volatile TSensor sensor;
+			sensor.temp = temps[k];
+			sensor.rh = rhs[m];
+			for(uint8_t v = 0;v < 2;v++)
+			{
+				uint16_t best = 0xFFFF;
+				for(uint8_t r = 0;r < DER_BENCH_RUNS;r++)
+				{
+					uint16_t dt;
+					ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+					{
+						uint16_t start = TCNT1;
+						if(v)
+							derive_float((TSensor*)&sensor);
+						else
+							derive((TSensor*)&sensor);
+						dt = TCNT1 - start;
+					}
+					if(dt < best)
+						best = dt;
+				}
+				sum[v] += best;
+			}
+		}
+	}
+	TCCR1B = tccr;
+	uint8_t count = sizeof(temps)/sizeof(temps[0])*sizeof(rhs);
+	*table = sum[0]/count;
+	*flt = sum[1]/count;
+}
+#endif
@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains derived humidity quantities of sensor readings.
+// See derive.c for details.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef DERIVE_H_
+#define DERIVE_H_
+
+#include <stdint.h>
+
+#include "tfa.h"
+
+// Magnus formula coefficients (Sonntag 1990, over water)
+#define DER_B 17.62 /* [-] */
+#define DER_C 243.12 /* [degC] */
+
+// tables range (1 degC steps, readings out of range are clamped)
+#define DER_T_MIN -40 /* [degC] */
+#define DER_T_MAX 60 /* [degC] */
+#define DER_T_STEPS (DER_T_MAX - DER_T_MIN + 1)
+#define DER_Q 12 /* fraction bits of logarithmic tables */
+
+// heat index defined from (otherwise it is temperature itself)
+#define DER_HI_T_MIN 267 /* [0.1 degC] */
+#define DER_HI_RH_MIN 40 /* [%] */
+
+// cycle benchmark of table vs. float libm implementation (SYST:BENCH:DERIV?, uses timer 1)
+#ifndef DERIVE_BENCH
+	#define DERIVE_BENCH 0
+#endif
+
+
+// --- functions:
+void derive(TSensor *sensor);
+int16_t derive_dew(int16_t temp, uint8_t rh);
+uint16_t derive_ah(int16_t temp, uint8_t rh);
+int16_t derive_hi(int16_t temp, uint8_t rh);
+#if DERIVE_BENCH
+void derive_bench(uint16_t *table, uint16_t *flt);
+#endif
+
+
+#endif
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel report-on-change filter.
+//
+// Sensors re-send the same data every cycle (~1 min) and sync button
+// produces bursts of identical transmissions. When the filter of channel
+// is enabled, received data are reported only if they differ from the last
+// reported data: sensor ID or flags changed, temperature or humidity moved
+// out of deadband around the last reported value, or nothing was reported
+// for heartbeat interval. Time base is seconds counter of receiver tick ISR
+// (16-bit, wraps after ~18 hours, differences are wrap safe).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tfa.h"
+#include "filter.h"
+
+// initialize filter (disabled)
+void filter_init(TFilter *filt)
+{
+	filt->flags = 0;
+	filt->temp_db = 0;
+	filt->rh_db = 0;
+	filt->heartbeat = 0;
+}
+
+// enable filter with deadbands temp_db [0.1 degC], rh_db [%] and heartbeat [s] (0 = no heartbeat)
+void filter_setup(TFilter *filt, uint8_t temp_db, uint8_t rh_db, uint16_t heartbeat)
+{
+	filt->temp_db = temp_db;
+	filt->rh_db = rh_db;
+	filt->heartbeat = heartbeat;
+	filt->flags = FILT_ON; // next data always reported
+}
+
+// check sensor data received at time [s], returns 1 if they should be reported
+uint8_t filter_check(TFilter *filt, TSensor *sensor, uint16_t time)
+{
+	if(!(filt->flags & FILT_ON))
+		return(1);
+
+	int16_t temp = sensor->temp;
+	uint8_t sens_flags = sensor->flags & (TFA_LOW_BATT | TFA_SYNC);
+	if((filt->flags & FILT_VALID) && filt->id == sensor->id && filt->sens_flags == sens_flags
+		&& abs(temp - filt->temp) <= filt->temp_db && abs((int16_t)sensor->rh - filt->rh) <= filt->rh_db
+		&& (!filt->heartbeat || (uint16_t)(time - filt->time) < filt->heartbeat))
+	{
+		// no meaningful change
+		return(0);
+	}
+
+	// report: store as last reported
+	filt->id = sensor->id;
+	filt->temp = temp;
+	filt->rh = sensor->rh;
+	filt->sens_flags = sens_flags;
+	filt->time = time;
+	filt->flags |= FILT_VALID;
+	return(1);
+}
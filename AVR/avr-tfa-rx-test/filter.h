@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel report-on-change filter.
+// See filter.c for details.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+
+#include "tfa.h"
+
+#define FILT_ON (1<<0) /* filter enabled */
+#define FILT_VALID (1<<1) /* last reported data valid */
+
+typedef struct{
+	uint8_t flags; /* control flags */
+	uint8_t temp_db; /* temperature deadband [0.1 degC] */
+	uint8_t rh_db; /* relative humidity deadband [%] */
+	uint16_t heartbeat; /* max silence interval [s], 0 = none */
+	// last reported data
+	uint8_t id;
+	int16_t temp; /* [0.1 degC] */
+	uint8_t rh;
+	uint8_t sens_flags; /* sensor flags (low battery, sync) */
+	uint16_t time; /* report time [s] */
+}TFilter;
+
+
+// --- functions:
+void filter_init(TFilter *filt);
+void filter_setup(TFilter *filt, uint8_t temp_db, uint8_t rh_db, uint16_t heartbeat);
+uint8_t filter_check(TFilter *filt, TSensor *sensor, uint16_t time);
+
+
+#endif
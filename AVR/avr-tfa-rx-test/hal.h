@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// Hardware abstraction: pin and peripheral traits of supported AVRs.
+// Everything is resolved by preprocessor, so there is no runtime cost.
+// Select MCU by compiler (-mmcu), pins can be overriden by -D for boards.
+// Up to 4 RX modules can be connected for antenna diversity (TFA_INPUTS,
+// pins ARX_MASK, defaults PD2, PD6, PD7), see tfa.c.
+//
+// Supported MCUs:
+//   ATmega644(A), ATmega644P(A), ATmega1284(P) - USART0, RXD on PD0/PCINT24
+//   ATmega328P, ATmega328                      - USART, RXD on PD0/PCINT16
+// Timer 0 (tick), Timer 1 (auto-baud) and USART 0 registers have the same
+// names on all of them. ATtiny parts have no USART with these registers
+// (or no 16-bit timer and SRAM for buffers) and are not supported, neither
+// is ATmega168 (1 kB SRAM, buffers need ~1.4 kB, see SRAM check in main.c).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <avr/io.h>
+
+// --- MCU traits ---
+#if defined(__AVR_ATmega644__) || defined(__AVR_ATmega644A__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega644PA__) \
+	|| defined(__AVR_ATmega1284__) || defined(__AVR_ATmega1284P__)
+	#define HAL_USART_RX_vect USART0_RX_vect /* UART receive vector */
+	#define HAL_RXD_PCINT_vect PCINT3_vect /* pin change vector of RXD pin (PD0) */
+	#define HAL_RXD_PCMSK PCMSK3
+	#define HAL_RXD_PCINT PCINT24
+	#define HAL_RXD_PCIE PCIE3
+#elif defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__)
+	#define HAL_USART_RX_vect USART_RX_vect
+	#define HAL_RXD_PCINT_vect PCINT2_vect
+	#define HAL_RXD_PCMSK PCMSK2
+	#define HAL_RXD_PCINT PCINT16
+	#define HAL_RXD_PCIE PCIE2
+#else
+	#error "Unsupported MCU, add its traits to hal.h."
+#endif
+// UART RXD pin
+#define HAL_RXD_PIN PIND
+#define HAL_RXD PD0
+
+
+// --- board pins (all supported MCUs have them on ports B and D) ---
+// data input from RX module
+#ifndef ARX_PORT
+	#define ARX_PORT PORTD
+	#define ARX_DDR DDRD
+	#define ARX_PIN PIND
+	#define ARX PD2
+#endif
+// data inputs of all RX modules (antenna diversity, TFA_INPUTS modules on ARX port, first is ARX)
+#ifndef ARX_MASK
+	#if TFA_INPUTS > 2
+		#define ARX_MASK ((1<<ARX)|(1<<PD6)|(1<<PD7))
+	#elif TFA_INPUTS > 1
+		#define ARX_MASK ((1<<ARX)|(1<<PD6))
+	#else
+		#define ARX_MASK (1<<ARX)
+	#endif
+#endif
+#define ARX_INPUTS (((ARX_MASK)>>0&1) + ((ARX_MASK)>>1&1) + ((ARX_MASK)>>2&1) + ((ARX_MASK)>>3&1) \
+	+ ((ARX_MASK)>>4&1) + ((ARX_MASK)>>5&1) + ((ARX_MASK)>>6&1) + ((ARX_MASK)>>7&1)) /* count of ARX_MASK pins */
+
+// TFA receiver LED
+#ifndef LED_PACKET_PORT
+	#define LED_PACKET_PORT PORTD
+	#define LED_PACKET_DDR DDRD
+	#define LED_PACKET PD3
+#endif
+
+// unread data LED
+#ifndef LED_UNREAD_PORT
+	#define LED_UNREAD_PORT PORTD
+	#define LED_UNREAD_DDR DDRD
+	#define LED_UNREAD PD4
+#endif
+
+// alarm output (active high while any channel alarm is active)
+#ifndef ALARM_PORT
+	#define ALARM_PORT PORTB
+	#define ALARM_DDR DDRB
+	#define ALARM PB0
+#endif
+
+// RTS output of UART flow control (RX_FLOW_RTS)
+#ifndef RTS_PORT
+	#define RTS_PORT PORTD
+	#define RTS_DDR DDRD
+	#define RTS PD5
+#endif
+
+
+#endif
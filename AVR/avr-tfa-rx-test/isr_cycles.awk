@@ -0,0 +1,119 @@
+# Worst path cycle count of ISRs from avr-objdump -d --no-show-raw-insn listing.
+# Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+#
+# Instructions of each __vector_* function form control flow graph (fall
+# through, branches, skips, jumps, AVR instruction set timing of classic core
+# with 16-bit PC) and the longest path from entry to reti is found over the
+# forward edges. Backward edges (loops) are not followed, so loop bodies are
+# counted once, and called functions are counted only by call/ret (they are
+# listed, so their cost can be added). Result is comparable with tick budget
+# as long as the ISR has no loops (loops are reported).
+#
+# (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+# The code and all its part are distributed under MIT license
+# https://opensource.org/licenses/MIT.
+
+BEGIN {
+	FS = "\t"
+	n = split("ld ldd st std lds sts push pop adiw sbiw mul muls mulsu fmul fmuls fmulsu rjmp ijmp sbi cbi",c2," ")
+	for(k = 1;k <= n;k++)
+		cyc[c2[k]] = 2
+	cyc["lpm"] = 3; cyc["elpm"] = 3; cyc["rcall"] = 3; cyc["icall"] = 3; cyc["jmp"] = 3
+	cyc["call"] = 4; cyc["ret"] = 4; cyc["reti"] = 4
+	n = split("brbs brbc breq brne brcs brcc brsh brlo brmi brpl brge brlt brhs brhc brts brtc brvs brvc brie brid",b," ")
+	for(k = 1;k <= n;k++)
+		branch[b[k]] = 1
+	n = split("cpse sbrc sbrs sbic sbis",b," ")
+	for(k = 1;k <= n;k++)
+		skip[b[k]] = 1
+	isr = ""
+}
+
+# function header: "00000ab2 <__vector_13>:"
+/^[0-9a-f]+ <.*>:$/ {
+	flush()
+	isr = ($0 ~ /<__vector_[0-9]+>:$/) ? $0 : ""
+	sub(/^.*</,"",isr); sub(/>:$/,"",isr)
+	insns = 0; calls = ""
+	next
+}
+
+# instruction: "     ab2:<tab>push<tab>r1<tab>; comment"
+isr != "" && $1 ~ /^ *[0-9a-f]+:$/ && NF >= 2 {
+	a = $1; gsub(/[ :]/,"",a)
+	op = $2; sub(/ .*$/,"",op)
+	insns++
+	addr[insns] = hex(a)
+	mnem[insns] = op
+	target[insns] = -1
+	if(match($0,/; 0x[0-9a-f]+/))
+		target[insns] = hex(substr($0,RSTART + 4,RLENGTH - 4))
+	if((op == "call" || op == "rcall") && match($0,/<[^>]+>/))
+		calls = calls " " substr($0,RSTART + 1,RLENGTH - 2)
+}
+
+function hex(s,  k,v) {
+	v = 0
+	for(k = 1;k <= length(s);k++)
+		v = v*16 + index("0123456789abcdef",substr(s,k,1)) - 1
+	return(v)
+}
+
+# index of instruction at address (0 if outside of ISR)
+function at(x,  k) {
+	for(k = 1;k <= insns;k++)
+		if(addr[k] == x)
+			return(k)
+	return(0)
+}
+
+# longest path from instruction i to path end (forward edges only)
+function path(i,  op,best,t,s,words) {
+	if(i < 1 || i > insns)
+		return(0)
+	if(i in memo)
+		return(memo[i])
+	op = mnem[i]
+	if(op == "ret" || op == "reti" || op == "ijmp")
+		best = cyc[op]
+	else if(op == "rjmp" || op == "jmp")
+	{
+		# forward jump inside ISR or tail jump out of it
+		t = at(target[i])
+		best = cyc[op] + ((t > i) ? path(t) : 0)
+		if(t && t <= i)
+			loops++
+	}
+	else if(op in branch)
+	{
+		best = 1 + path(i + 1)
+		t = at(target[i])
+		if(t > i && 2 + path(t) > best)
+			best = 2 + path(t)
+		if(t && t <= i)
+			loops++
+	}
+	else if(op in skip)
+	{
+		best = 1 + path(i + 1)
+		words = (i + 2 <= insns) ? (addr[i + 2] - addr[i + 1])/2 : 1
+		if(1 + words + path(i + 2) > best)
+			best = 1 + words + path(i + 2)
+	}
+	else
+		best = ((op in cyc) ? cyc[op] : 1) + path(i + 1)
+	memo[i] = best
+	return(best)
+}
+
+function flush() {
+	if(isr == "")
+		return
+	delete memo
+	loops = 0
+	printf "  %-12s %5d %5d %5d %s\n", isr, insns, path(1), loops, calls
+}
+
+END {
+	flush()
+}
@@ -3,17 +3,25 @@
 // Receives packets from ASK radio module (tested with Aurel AC-RX2/CS).
 // Communicates results via UART using standard SCPI style commands.
 // Developed for 8-bit AVR ATmega644, but will work on any AVR.
-// This demo uses internal clock of 8MHz, which limits selectable baudrates.
+// This demo uses internal clock of 8MHz, which limits selectable baudrates
+// (max 38400bd), set F_CPU of crystal for higher rates.
 //
 // Communication:
 //   Setup: 19200bd, 8bit, no parity, no flow control, 1stop
+//   (optional XON/XOFF or RTS flow control by RX_FLOW, see serial.h)
+//   (baud rate by USART_BAUDRATE checked for F_CPU, optional auto-baud by
+//   USART_AUTOBAUD: send 'U' first, see serial.h)
 //   SCPI style commands are terminated by LF (0x0A), can be chained by ';',
-//   maximum command chain is 127 bytes. Answers are LF terminated.
+//   maximum command chain is 127 bytes, single command (header with
+//   parameters) is max 63 bytes. Answers are LF terminated.
 //
 //   Supported commands:
 //     *IDN? - return identification string
 //     *RST - reboot
-//     SYST:ERR? - return last error if any
+//     *CLS - clear error queue
+//     SYST:COMM:OVER? - get RX overflow events and dropped bytes "events, bytes"
+//     SYST:COMM:BAUD? - get current baud rate
+//     SYST:ERR? - return oldest error from queue (4 errors), "0, No error." if empty
 //     TFA:TALK <0|1> - disable/enable auto reporting of received sensor data
 //     TFA:HEAD <0|1> - return data with text headers?
 //     TFA:DATA? - return last sensor data for any channel
@@ -24,10 +32,34 @@
 //     TFA:SYNC <1|2|3> - start synchronization for selected channel
 //     TFA:COUNT? - get received sensor data count
 //     TFA:COUNT:RESET - reset received sensor data count
+//     TFA:HIST:PULSE <0|1> - disable/enable low-pulse width histogram capture
+//     TFA:HIST:PULSE? - return low-pulse width histogram (binary block)
+//     TFA:HIST:RESET - clear low-pulse width histogram
+//     TFA:RAW <0|1> - disable/enable raw edge streaming
+//     TFA:RAW:LOST? - get count of raw edges lost due to stream overflow
+//     TFA:EARLY <0|2-7> - publish data after n identical repetitions (0=off)
+//     TFA:EARLY? - get early accept repetitions (0 if disabled)
+//     TFA:EARLY:SUPP <0|1> - suppress final data identical to early data?
+//     TFA:FILT <1|2|3>,<dT>,<dRH>[,<hb>] - report channel data only on change
+//     TFA:FILT? <1|2|3> - get filter setup "on, dT, dRH, hb"
+//     TFA:FILT:OFF <1|2|3> - disable filter (report all channel data)
+//     TFA:STAT? <1|2|3> - get delivery stats "id, period, received, missed, rate"
+//     TFA:STAT:RESET - reset delivery stats of all channels
+//     TFA:LISTEN <0|1> - relax glitch rejection when transmission is expected
+//     TFA:LISTEN? - get listen window state
+//     TFA:EVENT <mask> - subscribe events to be pushed (0 = none)
+//     TFA:EVENT? - get event subscription mask
+//     TFA:ALARM <1|2|3>,<tL>,<tH>,<rhL>,<rhH>[,<t_hyst>,<rh_hyst>,<deb>] - set alarm
+//     TFA:ALARM? <1|2|3> - get alarm "on, tL, tH, rhL, rhH, t_hyst, rh_hyst, deb, state"
+//     TFA:ALARM:OFF <1|2|3> - disable alarm of channel
+//     TFA:DERIV <0|1> - disable/enable derived quantities in reports
+//     TFA:DERIV? - get derived quantities reporting state
+//     SYST:BENCH:DERIV? - get cycles of derived quantities "table, float libm"
+//       (DERIVE_BENCH build only)
 //
 //   Reporting format:
-//     "id= 9, chn=2, t=23.7"C, rh=45%, batt=1, sync=0\n" with headers
-//     "9, 2, 23.7, 45, 1, 0\n" without headers
+//     "id= 9, chn=2, t=23.7"C, rh=45%, batt=1, sync=0, q=86%\n" with headers
+//     "9, 2, 23.7, 45, 1, 0, 86\n" without headers
 //
 //     id - random sensor 4-bit ID
 //     chn - channel setup as on switch in sensor (1-3)
@@ -35,6 +67,80 @@
 //     rh - relative humidity [%]
 //     batt - 1 of low battery
 //     sync - 1 if sync button on sensor pressed, 0 for normal reporting
+//     q - link quality [%] (see below)
+//
+//     With derived quantities enabled (TFA:DERIV 1) reports are extended:
+//     "..., q=86%, dp=11.2"C, ah=9.6g/m3, hi=23.7"C\n" with headers
+//     "..., 86, 11.2, 9.6, 23.7\n" without headers
+//
+//     dp - dew point [degC]
+//     ah - absolute humidity [g/m3]
+//     hi - heat index [degC] (temperature itself below 26.7 degC or 40 %)
+//
+//   Histogram format:
+//     "#3512<data>\n" - SCPI definite length block of 256 bins, each bin
+//     is uint16 little endian count of low-pulses with width of bin index
+//     in ticks of 50us, last bin counts all pulses of 255 ticks or longer.
+//     Counters saturate at 65535. Captured from live traffic to tune TFA_T_*.
+//
+//   Link quality:
+//     Score 0-100% estimated from the reception (no RSSI needed): identical
+//     repetitions received of 7, minus penalties for repetitions of the same
+//     sensor disagreeing with elected data, glitches during transmission and
+//     std. deviation of gap widths (weights TFA_Q_* in tfa.h). Steady drop
+//     of the score signals failing link before readings are lost. Early
+//     accepted data are scored from repetitions received so far.
+//
+//   Early accept:
+//     Sensor data are normally published after end of transmission (all 7
+//     repetitions, ~1 s). In early mode the data are published as soon as n
+//     identical consecutive repetitions are received. With suppression the
+//     same data elected at the end of transmission are not published again.
+//
+//   Report-on-change filter:
+//     Filtered channel data are reported (talk mode, new data flags) only if
+//     sensor ID or flags changed, temperature moved by more than dT [0.1 degC]
+//     or humidity by more than dRH [%] from last reported data or nothing was
+//     reported for hb [s] (heartbeat, 0 = none). Received data are stored anyway.
+//
+//   Events:
+//     Instead of polling TFA:DATA:NEW? host subscribes events by mask: bits
+//     0-2 - new (reported, see filter) data of channel 1-3, bit 3 - low battery
+//     flag of channel sensor changed, bit 4 - sync transmission, bit 5 - alarm
+//     state of channel changed. Receiver
+//     pushes event line for each reading with subscribed events:
+//       "!<events hex>, <id>, <chn>, <t>, <rh>, <batt>, <sync>, <q>\n"
+//     e.g. "!01, 9, 1, 23.7, 45, 0, 0, 86\n" (not sent while streaming).
+//
+//   Threshold alarms:
+//     Limits of channel sensor temperature [0.1 degC] and humidity [%] with
+//     hysteresis (default 0.5 degC, 2 %) and debounce (consecutive
+//     transmissions to change state, default 1) are checked on every
+//     transmission. On alarm state change the receiver immediately sends
+//     alarm frame ahead of reports (also with talk mode off):
+//       "!A, <chn>, <state hex>, <t>, <rh>\n"
+//     state bits: 0 - t low, 1 - t high, 2 - rh low, 3 - rh high. Alarm
+//     output (ALARM pin, see hal.h) is high while any alarm is active.
+//
+//   Delivery statistics:
+//     Transmission period [s] of channel sensor is estimated from intervals
+//     between received transmissions, missed expected transmissions (also
+//     overdue ones) are counted, rate is received/(received+missed) [%].
+//     Listen window relaxes glitch rejection of decoder (TFA_T_GLITCH_LISTEN_US)
+//     +-3 s around expected transmission of any channel sensor (see period.c).
+//
+//   Derived quantities:
+//     Computed on receiver from fixed-point tables in flash without float
+//     libm (see derive.c), so host needs not to convert every reading.
+//     Cycles per reading of table and libm implementations are measured
+//     by SYST:BENCH:DERIV? in build with DERIVE_BENCH=1 (uses timer 1,
+//     interrupts are disabled during each timed call).
+//
+//   Raw edge streaming:
+//     Binary stream of durations of each RX module output level in 50us ticks,
+//     one symbol per edge, coding see tfa_core.h. Decoded by host tool
+//     host/tfa_raw. Talk mode reports are not sent while streaming, answers
+//     to queries are mixed into the stream, so stop streaming before query.
 //
 //
 // (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
@@ -58,7 +164,22 @@
 
 #include "main.h"
 #include "tfa.h"
+#include "tfa_core.h"
 #include "serial.h"
+#include "filter.h"
+#include "period.h"
+#include "alarm.h"
+#include "derive.h"
+
+// --- SRAM check (rough estimate of the largest buffers, receiver state and minimum stack) ---
+#define RAM_STAT 15 /* sizeof(TTFAStat) */
+#define RAM_BUFFERS (TFA_HIST_BINS*2 + RX_BUF_SZ + RX_CMD_MAX + SCPI_ERR_QUEUE*(SCPI_ERR_MAXBUF + 4) + TFA_RAW_BUF \
+	+ TFA_INPUTS*((TFA_SLOTS + 1)*TFA_BUF_BYTES + 2*RAM_STAT + 6)) /* static buffers and packet assemblers [B] */
+#define RAM_TFA ((TFA_POOL + 4*TFA_CANDIDATES + 2)*TFA_BUF_BYTES + 2*RAM_STAT + 16) /* TTFA of main() [B] */
+#define RAM_STACK_MIN 256 /* other main() locals, call frames and ISR frames [B] */
+#if RAM_BUFFERS + RAM_TFA + RAM_STACK_MIN > RAMEND - RAMSTART + 1
+	#error "Buffers do not fit SRAM of MCU, reduce TFA_INPUTS or RX_BUF_SZ, or choose MCU with more SRAM."
+#endif
 
 // --- jump to bootloader ---
 #define boot_start(boot_addr) {goto *(const void* PROGMEM)boot_addr;}
@@ -70,12 +191,72 @@ void tfa_print_sensor(TSystem *syst, TSensor *sensor)
 {
 	char str[64];
 	if(syst->flags & SYST_HEAD)
-		sprintf_P(str,PSTR("id=%2u, chn=%u, t=%0.1f\"C, rh=%u%%, batt=%u, sync=%u\n"),sensor->id,sensor->channel,sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags));
+		sprintf_P(str,PSTR("id=%2u, chn=%u, t=%0.1f\"C, rh=%u%%, batt=%u, sync=%u, q=%u%%"),sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags),sensor->quality);
 	else
-		sprintf_P(str,PSTR("%2u, %u, %0.1f, %u, %u, %u\n"),sensor->id,sensor->channel,sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags));
+		sprintf_P(str,PSTR("%2u, %u, %0.1f, %u, %u, %u, %u"),sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags),sensor->quality);
+	serial_tx_str(str);
+	if(syst->flags & SYST_DERIV)
+	{
+		// derived quantities
+		if(syst->flags & SYST_HEAD)
+			sprintf_P(str,PSTR(", dp=%0.1f\"C, ah=%0.1fg/m3, hi=%0.1f\"C"),0.1*sensor->dew,0.01*sensor->ah,0.1*sensor->hi);
+		else
+			sprintf_P(str,PSTR(", %0.1f, %0.1f, %0.1f"),0.1*sensor->dew,0.01*sensor->ah,0.1*sensor->hi);
+		serial_tx_str(str);
+	}
+	serial_tx_cstr(PSTR("\n"));
+}
+
+// push event line (events bits, channel sensor data without headers)
+void tfa_print_event(uint8_t events, TSensor *sensor)
+{
+	char str[48];
+	sprintf_P(str,PSTR("!%02X, %u, %u, %0.1f, %u, %u, %u, %u\n"),events,sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags),sensor->quality);
 	serial_tx_str(str);
 }
 
+// push alarm frame (channel, alarm state bits, temperature, humidity)
+void tfa_print_alarm(uint8_t chn, uint8_t state, TSensor *sensor)
+{
+	char str[32];
+	sprintf_P(str,PSTR("!A, %u, %X, %0.1f, %u\n"),chn,state,0.1*sensor->temp,sensor->rh);
+	serial_tx_str(str);
+}
+
+// parse comma separated list of integer parameters, returns count of values or 0 if format is invalid
+uint8_t scpi_par_ints(char *par, int32_t *val, uint8_t max)
+{
+	uint8_t count = 0;
+	while(par && count < max)
+	{
+		char *end;
+		val[count++] = strtol(par,&end,10);
+		if(end == par || (*end && *end != ','))
+			return(0);
+		par = (*end == ',')?(end + 1):NULL;
+	}
+	if(par)
+		return(0); // too many values
+	return(count);
+}
+
+// print low-pulse width histogram as SCPI binary block
+void tfa_print_hist(void)
+{
+	char str[8];
+	uint16_t size = TFA_HIST_BINS*sizeof(uint16_t);
+	sprintf_P(str,PSTR("#0%u"),size);
+	str[1] = '0' + strlen(str) - 2; // size digits count
+	serial_tx_str(str);
+	for(uint16_t k = 0;k < TFA_HIST_BINS;k++)
+	{
+		uint16_t count = tfa_hist_get(k);
+		serial_tx_byte(low(count));
+		serial_tx_byte(high(count));
+	}
+	serial_tx_cstr(PSTR("\n"));
+}
+
 
 // --- MAIN ---
 int main(void)
@@ -93,15 +274,25 @@ int main(void)
 	serial_init();
 
 	// system control&status
-	TSystem syst = {0,SYST_TALK|SYST_HEAD};
+	TSystem syst = {0,SYST_TALK|SYST_HEAD,0};
 
 	// sensor channels (holds last data for each channel)
 	TSensor sensors[3];
+	TFilter filters[SENSOR_CHANNELS];
+	TPeriod periods[SENSOR_CHANNELS];
+	TAlarm alarms[SENSOR_CHANNELS];
 	for(uint8_t k=0;k<SENSOR_CHANNELS;k++)
 	{
 		sensors[k].id = 0xFF; // reset channel ID (sync)
 		sensors[k].flags = 0; // no data yet
+		filter_init(&filters[k]); // report all data
+		period_init(&periods[k]);
+		alarm_init(&alarms[k]);
 	}
+
+	// alarm output
+	sbi(ALARM_DDR,ALARM);
+	uint16_t listen_time = 0;
 	
 	// enable global IRQ
 	sei();
@@ -110,14 +301,14 @@ int main(void)
     while(1)
 	{		
 		// --- SCPI command handlers:
-		char str[32]; // response buffer
-		char cmdbuf[RX_BUF_SZ]; // local command buffer
+		char str[48]; // response buffer
+		char *cmd; // command (in place in receive buffer)
 		char *par;
-		if(serial_decode(cmdbuf,&par)) // check and eventual SCPI command presence
+		if(serial_decode(&cmd,&par)) // check and eventual SCPI command presence
 		{
 			// yaha, some command present: decode
 
-			if(!strcmp_P(cmdbuf,PSTR("TFA:TALK")))
+			if(!strcmp_P(cmd,PSTR("TFA:TALK")))
 			{
 				// TFA:TALK <state> - enable or disable auto reporting of received packet {0,1}
 				if(!par || *par < '0' || *par > '1')
@@ -128,7 +319,7 @@ int main(void)
 				syst.flags &= ~SYST_TALK;
 				syst.flags |= (*par - '0')*SYST_TALK;
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:HEAD")))
+			else if(!strcmp_P(cmd,PSTR("TFA:HEAD")))
 			{
 				// TFA:HEAD <state> - enable or disable headers when reporting data {0,1}
 				if(!par || *par < '0' || *par > '1')
@@ -139,7 +330,7 @@ int main(void)
 				syst.flags &= ~SYST_HEAD;
 				syst.flags |= (*par - '0')*SYST_HEAD;
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:DATA:NEW?")))
+			else if(!strcmp_P(cmd,PSTR("TFA:DATA:NEW?")))
 			{
 				// TFA:DATA:NEW? <channel> - new unread sensor data available? optional <channel> points to particular sensor channel
 				uint8_t chn = 0;
@@ -163,7 +354,7 @@ int main(void)
 				else
 					serial_tx_cstr(PSTR("0\n"));
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:DATA?")))
+			else if(!strcmp_P(cmd,PSTR("TFA:DATA?")))
 			{
 				// TFA:DATA? <channel> - read last received sensor data (any sensor) or particular sensor <channel>
 				uint8_t chn = 0;
@@ -182,7 +373,10 @@ int main(void)
 					// parse and print sensor data
 					TSensor sensor;
 					if(tfa_parse(&tfa,&sensor))
+					{
+						derive(&sensor);
 						tfa_print_sensor(&syst,&sensor);
+					}
 					else
 						serial_tx_cstr(PSTR("error parsing data: unknown sensor type?\n"));										
 				}
@@ -198,7 +392,7 @@ int main(void)
 					tfa.flags &= ~TFA_NEW_PACKET;
 				}
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:SYNC")))
+			else if(!strcmp_P(cmd,PSTR("TFA:SYNC")))
 			{
 				// TFA:SYNC <channel> - start synchronization with sensor, optional <channel> points to particular channel
 				uint8_t chn = 0;
@@ -224,7 +418,7 @@ int main(void)
 					sensors[chn-1].id = 0xFF;
 				}				
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:COUNT?")))
+			else if(!strcmp_P(cmd,PSTR("TFA:COUNT?")))
 			{
 				// TFA:COUNT? - get received sensor data count
 				if(par)
@@ -235,7 +429,7 @@ int main(void)
 				sprintf(str,"%u\n",syst.packets);
 				serial_tx_str(str);				
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("TFA:COUNT:RESET")))
+			else if(!strcmp_P(cmd,PSTR("TFA:COUNT:RESET")))
 			{
 				// TFA:COUNT:RESET - reset received sensor data count
 				if(par)
@@ -245,32 +439,334 @@ int main(void)
 				}
 				syst.packets = 0;
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("*IDN?")))
+			else if(!strcmp_P(cmd,PSTR("TFA:STAT?")))
+			{
+				// TFA:STAT? <channel> - get delivery statistics of channel sensor
+				int32_t chn;
+				if(scpi_par_ints(par,&chn,1) != 1 || chn < 1 || chn > SENSOR_CHANNELS)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:STAT? <channel> parameter must be 1 to 3."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				TPeriod *per = &periods[chn-1];
+				uint16_t missed = period_missed(per,tfa_time());
+				uint32_t total = (uint32_t)per->received + missed;
+				sprintf_P(str,PSTR("%u, %0.1f, %u, %u, %0.1f\n"),per->id,(float)per->period/PER_FRAC,per->received,missed,total?100.0*per->received/total:0.0);
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:STAT:RESET")))
+			{
+				// TFA:STAT:RESET - reset delivery statistics of all channels
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:STAT:RESET"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				for(uint8_t k = 0;k < SENSOR_CHANNELS;k++)
+				{
+					// keep period estimate
+					periods[k].received = 0;
+					periods[k].missed = 0;
+				}
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:LISTEN")))
+			{
+				// TFA:LISTEN <state> - enable or disable listen window around expected transmissions {0,1}
+				if(!par || *par < '0' || *par > '1')
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:LISTEN parameter must be 0 or 1."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				syst.flags &= ~SYST_LISTEN;
+				syst.flags |= (*par - '0')*SYST_LISTEN;
+				tfa_listen(0);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:LISTEN?")))
+			{
+				// TFA:LISTEN? - get listen window state
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:LISTEN?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf(str,"%u\n",!!(syst.flags & SYST_LISTEN));
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:EVENT")))
+			{
+				// TFA:EVENT <mask> - set event subscription mask (pushed event lines)
+				int32_t mask;
+				if(scpi_par_ints(par,&mask,1) != 1 || mask < 0 || mask > EVT_ALL)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:EVENT parameter must be event mask 0 to 63."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				syst.events = (uint8_t)mask;
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:EVENT?")))
+			{
+				// TFA:EVENT? - get event subscription mask
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:EVENT?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf(str,"%u\n",syst.events);
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:ALARM")))
+			{
+				// TFA:ALARM <channel>,<t_low>,<t_high>,<rh_low>,<rh_high>[,<t_hyst>,<rh_hyst>,<debounce>] - enable threshold alarm of channel
+				int32_t val[8];
+				uint8_t count = scpi_par_ints(par,val,8);
+				if(count < 5 || val[0] < 1 || val[0] > SENSOR_CHANNELS || val[1] < -999 || val[2] > 999 || val[1] >= val[2]
+					|| val[3] < 0 || val[4] > 100 || val[3] >= val[4]
+					|| (count > 5 && (val[5] < 0 || val[5] > 255)) || (count > 6 && (val[6] < 0 || val[6] > 100))
+					|| (count > 7 && (val[7] < 1 || val[7] > ALM_DEBOUNCE_MAX)))
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:ALARM parameters must be <1-3>,<t_low>,<t_high>,<rh_low>,<rh_high>[,<t_hyst>,<rh_hyst>,<1-15>]."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				alarm_setup(&alarms[val[0]-1],val[1],val[2],val[3],val[4],(count > 5)?val[5]:5,(count > 6)?val[6]:2,(count > 7)?val[7]:1);
+				// re-armed alarm starts inactive
+				alarm_output(alarms,SENSOR_CHANNELS);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:ALARM?")) || !strcmp_P(cmd,PSTR("TFA:ALARM:OFF")))
+			{
+				// TFA:ALARM? <channel> - get alarm setup and state of channel
+				// TFA:ALARM:OFF <channel> - disable alarm of channel
+				int32_t chn;
+				if(scpi_par_ints(par,&chn,1) != 1 || chn < 1 || chn > SENSOR_CHANNELS)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:ALARM? and TFA:ALARM:OFF <channel> parameter must be 1 to 3."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				TAlarm *alm = &alarms[chn-1];
+				if(cmd[9] == '?')
+				{
+					sprintf_P(str,PSTR("%u, %d, %d, %u, %u, %u, %u, %u, %X\n"),!!(alm->flags & ALM_ON),alm->t_low,alm->t_high,alm->rh_low,alm->rh_high,alm->t_hyst,alm->rh_hyst,alm->debounce,alm->state);
+					serial_tx_str(str);
+				}
+				else
+				{
+					alarm_init(alm);
+					alarm_output(alarms,SENSOR_CHANNELS);
+				}
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:DERIV")))
+			{
+				// TFA:DERIV <state> - enable or disable derived quantities in reports {0,1}
+				if(!par || *par < '0' || *par > '1')
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:DERIV parameter must be 0 or 1."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				syst.flags &= ~SYST_DERIV;
+				syst.flags |= (*par - '0')*SYST_DERIV;
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:DERIV?")))
+			{
+				// TFA:DERIV? - get derived quantities reporting state
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:DERIV?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf(str,"%u\n",!!(syst.flags & SYST_DERIV));
+				serial_tx_str(str);
+			}
+#if DERIVE_BENCH
+			else if(!strcmp_P(cmd,PSTR("SYST:BENCH:DERIV?")))
+			{
+				// SYST:BENCH:DERIV? - get average cycles per reading of derived quantities: table, float libm implementation
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for SYST:BENCH:DERIV?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				uint16_t table, flt;
+				derive_bench(&table,&flt);
+				sprintf_P(str,PSTR("%u, %u\n"),table,flt);
+				serial_tx_str(str);
+			}
+#endif
+			else if(!strcmp_P(cmd,PSTR("TFA:HIST:PULSE")))
+			{
+				// TFA:HIST:PULSE <state> - enable or disable low-pulse width histogram capture {0,1}
+				if(!par || *par < '0' || *par > '1')
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:HIST:PULSE parameter must be 0 or 1."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+				{
+					tfa.flags &= ~TFA_HIST;
+					tfa.flags |= (*par - '0')*TFA_HIST;
+				}
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:HIST:PULSE?")))
+			{
+				// TFA:HIST:PULSE? - return low-pulse width histogram as binary block
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:HIST:PULSE?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				tfa_print_hist();
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:HIST:RESET")))
+			{
+				// TFA:HIST:RESET - clear low-pulse width histogram
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:HIST:RESET"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				tfa_hist_clear();
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:RAW")))
+			{
+				// TFA:RAW <state> - enable or disable raw edge streaming {0,1}
+				if(!par || *par < '0' || *par > '1')
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:RAW parameter must be 0 or 1."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				tfa_raw_mode(&tfa,*par - '0');
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:RAW:LOST?")))
+			{
+				// TFA:RAW:LOST? - get count of raw edges lost due to stream overflow
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:RAW:LOST?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf(str,"%u\n",tfa_raw_get_lost());
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:EARLY")))
+			{
+				// TFA:EARLY <reps> - publish data after reps identical repetitions {0,2-7}, 0 to disable
+				int32_t reps;
+				if(scpi_par_ints(par,&reps,1) != 1 || reps < 0 || (reps && (reps < TFA_EARLY_MIN || reps > TFA_PACKETS)))
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:EARLY parameter must be 0 or 2 to 7."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				tfa_early_mode(&tfa,(uint8_t)reps,!!(tfa.flags & TFA_EARLY_SUPP));
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:EARLY?")))
+			{
+				// TFA:EARLY? - get early accept repetitions
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for TFA:EARLY?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf(str,"%u\n",tfa_early_get());
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:EARLY:SUPP")))
+			{
+				// TFA:EARLY:SUPP <state> - suppress final data identical to early accepted data {0,1}
+				if(!par || *par < '0' || *par > '1')
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:EARLY:SUPP parameter must be 0 or 1."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				tfa_early_mode(&tfa,tfa_early_get(),*par - '0');
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:FILT")))
+			{
+				// TFA:FILT <channel>,<temp_db>,<rh_db>,<heartbeat> - enable report-on-change filter of channel
+				int32_t val[4];
+				uint8_t count = scpi_par_ints(par,val,4);
+				if(count < 3 || val[0] < 1 || val[0] > SENSOR_CHANNELS || val[1] < 0 || val[1] > 255 || val[2] < 0 || val[2] > 100
+					|| (count > 3 && (val[3] < 0 || val[3] > 65535)))
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:FILT parameters must be <1-3>,<0-255>,<0-100>[,<0-65535>]."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				filter_setup(&filters[val[0]-1],val[1],val[2],(count > 3)?val[3]:0);
+			}
+			else if(!strcmp_P(cmd,PSTR("TFA:FILT?")) || !strcmp_P(cmd,PSTR("TFA:FILT:OFF")))
+			{
+				// TFA:FILT? <channel> - get filter setup of channel
+				// TFA:FILT:OFF <channel> - disable filter of channel (report all data)
+				int32_t chn;
+				if(scpi_par_ints(par,&chn,1) != 1 || chn < 1 || chn > SENSOR_CHANNELS)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("TFA:FILT? and TFA:FILT:OFF <channel> parameter must be 1 to 3."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				TFilter *filt = &filters[chn-1];
+				if(cmd[8] == '?')
+				{
+					sprintf_P(str,PSTR("%u, %u, %u, %u\n"),!!(filt->flags & FILT_ON),filt->temp_db,filt->rh_db,filt->heartbeat);
+					serial_tx_str(str);
+				}
+				else
+					filter_init(filt);
+			}
+			else if(!strcmp_P(cmd,PSTR("*IDN?")))
 			{
 				// "*IDN?" to return IDN string
 				serial_tx_cstr(PSTR("TFA Dostmann 30.3215.02 radio interface by Stanislav Maslan, V1.0, " __DATE__ "\n"));
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("*RST")))
+			else if(!strcmp_P(cmd,PSTR("*RST")))
 			{
 				// *RST - restarts controller
 				cli();
 				boot_start(0x0000ul);
 				while(1);
 			}
-			else if(!strcmp_P(cmdbuf,PSTR("SYST:ERR?")))
+			else if(!strcmp_P(cmd,PSTR("SYST:ERR?")))
+			{
+				// SYST:ERR? - return oldest error from queue
+				serial_error(SCPI_ERR_noError,NULL,SCPI_ERR_SEND);
+			}
+			else if(!strcmp_P(cmd,PSTR("SYST:COMM:OVER?")))
+			{
+				// SYST:COMM:OVER? - get RX buffer overflow events and dropped bytes
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for SYST:COMM:OVER?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				uint16_t events, bytes;
+				serial_get_over(&events,&bytes);
+				sprintf_P(str,PSTR("%u, %u\n"),events,bytes);
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("SYST:COMM:BAUD?")))
+			{
+				// SYST:COMM:BAUD? - get current baud rate
+				if(par)
+				{
+					serial_error(SCPI_ERR_wrongParamType,PSTR("No parameters expected for SYST:COMM:BAUD?"),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+					goto SCPI_error;
+				}
+				sprintf_P(str,PSTR("%lu\n"),(unsigned long)serial_get_baud());
+				serial_tx_str(str);
+			}
+			else if(!strcmp_P(cmd,PSTR("*CLS")))
 			{
-				// SYST:ERR? - return last error
-				serial_error(SCPI_ERR_undefinedHeader,NULL,SCPI_ERR_SEND);
+				// *CLS - clear error queue
+				serial_error(SCPI_ERR_noError,NULL,SCPI_ERR_CLEAR);
 			}			
 			else
 			{
 				// invalid
-				serial_error(SCPI_ERR_undefinedHeader,cmdbuf,SCPI_ERR_STORE|SCPI_ERR_STR);
+				serial_error(SCPI_ERR_undefinedHeader,cmd,SCPI_ERR_STORE|SCPI_ERR_STR);
 				goto SCPI_error;
 			}
 
 			// nasty error handler :)
 			SCPI_error:;
+
+			// command processed: free its space in receive buffer
+			serial_release();
 		}
 
 		// unread data LED
@@ -279,8 +775,24 @@ int main(void)
 		else
 			cbi(LED_UNREAD_PORT,LED_UNREAD)
 
-		// --- offloaded received packets processing:
-		if(tfa_proc_packets(&tfa))
+		// --- raw edge streaming (limited chunk so noisy input cannot block SCPI):
+		uint8_t raw;
+		for(uint8_t k = 0;k < TFA_RAW_BUF && tfa_raw_pop(&raw);k++)
+			serial_tx_byte(raw);
+
+		// --- listen window around expected transmissions (checked once per second):
+		uint16_t now = tfa_time();
+		if((syst.flags & SYST_LISTEN) && now != listen_time)
+		{
+			uint8_t listen = 0;
+			for(uint8_t k = 0;k < SENSOR_CHANNELS;k++)
+				listen |= period_listen(&periods[k],now);
+			tfa_listen(listen);
+			listen_time = now;
+		}
+
+		// --- offloaded received packets processing (one or more sensors per reception):
+		while(tfa_proc_packets(&tfa))
 		{			
 			// new packet received: decode
 			TSensor sensor;
@@ -288,19 +800,55 @@ int main(void)
 			if(type_ok)
 			{
 				// sensor type matching
+				derive(&sensor);
 				
 				// update statistics
 				syst.packets++;
 
+				uint8_t report = 1;
+				uint8_t events = 0;
 				if(sensor.channel > 0 && sensor.channel <= SENSOR_CHANNELS)
 				{
 					// copy new sensor data to channel if ID match or not yet assigned ID (sync mode)
 					TSensor *dsens = &sensors[sensor.channel - 1];					
 					if(dsens->id == 0xFF || dsens->id == sensor.id)
+					{
+						// delivery statistics
+						uint8_t new_tx = period_update(&periods[sensor.channel - 1],&sensor,tfa_time());
+						// threshold alarms (once per transmission): frame is sent ahead of any report
+						TAlarm *alm = &alarms[sensor.channel - 1];
+						if(new_tx && alarm_check(alm,&sensor))
+						{
+							events |= EVT_ALARM;
+							if(!(tfa.flags & TFA_RAW))
+								tfa_print_alarm(sensor.channel,alm->state,&sensor);
+							alarm_output(alarms,SENSOR_CHANNELS);
+						}
+						// report-on-change filter (data are updated anyway, but not marked as new if not changed)
+						report = filter_check(&filters[sensor.channel - 1],&sensor,tfa_time());
+						uint8_t unread = dsens->flags & TFA_NEW_PACKET;
+						// events of channel (no data yet have flags cleared)
+						if((dsens->flags ^ sensor.flags) & TFA_LOW_BATT)
+							events |= EVT_LOW_BATT;
+						if(sensor.flags & TFA_SYNC)
+							events |= EVT_SYNC;
+						if(report)
+							events |= EVT_CHN(sensor.channel);
 						memcpy((void*)dsens,(void*)&sensor,sizeof(TSensor));
+						if(!report)
+							dsens->flags = (dsens->flags & ~TFA_NEW_PACKET) | unread;
+					}
 				}
 
-				if(syst.flags & SYST_TALK)
+				if(!report)
+				{
+					// filtered out: do not signal new data
+					ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+					{
+						tfa.flags &= ~TFA_NEW_PACKET;
+					}
+				}
+				else if((syst.flags & SYST_TALK) && !(tfa.flags & TFA_RAW))
 				{
 					// talk mode: report any valid packet now and clear new data flag
 					tfa_print_sensor(&syst,&sensor);
@@ -309,6 +857,17 @@ int main(void)
 						tfa.flags &= ~TFA_NEW_PACKET;
 					}
 				}
+
+				// push subscribed events (host needs not to poll)
+				events &= syst.events;
+				if(events && !(tfa.flags & TFA_RAW))
+				{
+					tfa_print_event(events,&sensor);
+					ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+					{
+						tfa.flags &= ~TFA_NEW_PACKET;
+					}
+				}
 			}
 		}
 	}
@@ -27,28 +27,25 @@
 // system control
 #define SYST_TALK (1<<0) /* auto talk mode when packet received? */
 #define SYST_HEAD (1<<1) /* show headers when reporting packet data? */
+#define SYST_LISTEN (1<<2) /* listen window around expected transmissions enabled? */
+#define SYST_DERIV (1<<3) /* report derived quantities (dew point, abs. humidity, heat index)? */
+
+// event subscription mask (pushed event lines)
+#define EVT_CHN(chn) (1<<((chn)-1)) /* new (reported) data of channel 1-3 */
+#define EVT_LOW_BATT (1<<3) /* low battery flag of channel sensor changed */
+#define EVT_SYNC (1<<4) /* sync transmission of channel sensor */
+#define EVT_ALARM (1<<5) /* alarm state of channel changed */
+#define EVT_ALL (EVT_CHN(1)|EVT_CHN(2)|EVT_CHN(3)|EVT_LOW_BATT|EVT_SYNC|EVT_ALARM)
 
 typedef struct{
 	uint16_t packets; /* received packets */
 	uint8_t flags; /* control flags */
+	uint8_t events; /* event subscription mask */
 }TSystem;
 
 
-// data input from RX module
-#define ARX_PORT PORTD
-#define ARX_DDR DDRD
-#define ARX_PIN PIND
-#define ARX PD2
-
-// TFA receiver LED
-#define LED_PACKET_PORT PORTD
-#define LED_PACKET_DDR DDRD
-#define LED_PACKET PD3
-
-// unread data LED
-#define LED_UNREAD_PORT PORTD
-#define LED_UNREAD_DDR DDRD
-#define LED_UNREAD PD4
+// board pins: see hal.h
+#include "hal.h"
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel transmission period estimation and
+// delivery statistics.
+//
+// Sensors transmit on regular interval (~1 min, slightly different for
+// each sensor). Interval between two received transmissions of the channel
+// sensor is n periods, where n-1 transmissions were missed. The period is
+// estimated from the first interval and then tracked by exponential average
+// of interval/n. Interval shorter than half of the estimate means it was
+// a multiple of the real period, so it restarts the estimate. Transmissions
+// closer than PER_MIN are duplicates (early and final data, more sensors
+// of one reception) and sync button transmissions restart the schedule.
+// Time base is seconds counter of receiver tick ISR (16-bit, wraps after
+// ~18 hours, differences are wrap safe), averaging hides its resolution.
+//
+// Knowing the period the receiver can tell when the next transmission is
+// expected, so main loop can relax glitch rejection of the decoder in
+// the listen window around that time (see tfa_listen()).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "tfa.h"
+#include "period.h"
+
+// initialize period estimator (no sensor tracked)
+void period_init(TPeriod *per)
+{
+	per->id = 0xFF;
+	per->period = 0;
+	per->received = 0;
+	per->missed = 0;
+}
+
+// update by sensor data received at time [s], returns 0 if data belong to the last transmission
+uint8_t period_update(TPeriod *per, TSensor *sensor, uint16_t time)
+{
+	if(per->id != sensor->id)
+	{
+		// new sensor: restart statistics
+		period_init(per);
+		per->id = sensor->id;
+		per->last = time;
+		per->received = 1;
+		return(1);
+	}
+
+	uint16_t dt = time - per->last;
+	if(dt < PER_MIN)
+		return(0); // the same transmission
+	per->last = time;
+	if(per->received < 0xFFFFu)
+		per->received++;
+	if(SENSOR_IS_SYNC(sensor->flags))
+		return(1); // out of schedule
+
+	uint32_t dt_frac = (uint32_t)dt*PER_FRAC;
+	if(!per->period)
+	{
+		// first estimate
+		if(dt <= PER_MAX)
+			per->period = dt_frac;
+		return(1);
+	}
+	uint16_t n = (dt_frac + per->period/2)/per->period;
+	if(!n)
+	{
+		// estimate was multiple of real period
+		per->period = dt_frac;
+		return(1);
+	}
+	uint32_t missed = (uint32_t)per->missed + n - 1;
+	per->missed = (missed > 0xFFFFu)?0xFFFFu:missed;
+	int16_t err = (int32_t)(dt_frac/n) - per->period;
+	per->period += (err + ((err < 0)?-PER_AVG/2:PER_AVG/2))/PER_AVG;
+	return(1);
+}
+
+// get missed transmissions including overdue ones at time [s]
+uint16_t period_missed(TPeriod *per, uint16_t time)
+{
+	uint32_t missed = per->missed;
+	if(per->period)
+	{
+		// transmissions expected since last one (late by half period)
+		uint16_t n = ((uint32_t)(uint16_t)(time - per->last)*PER_FRAC + per->period/2)/per->period;
+		if(n > 1)
+			missed += n - 1;
+	}
+	return((missed > 0xFFFFu)?0xFFFFu:missed);
+}
+
+// is time [s] in listen window around expected transmission?
+uint8_t period_listen(TPeriod *per, uint16_t time)
+{
+	if(!per->period)
+		return(0);
+	uint16_t phase = ((uint32_t)(uint16_t)(time - per->last)*PER_FRAC) % per->period;
+	return(phase <= PER_LISTEN*PER_FRAC || per->period - phase <= PER_LISTEN*PER_FRAC);
+}
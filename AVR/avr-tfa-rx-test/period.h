@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains per-channel transmission period estimation and
+// delivery statistics. See period.c for details.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef PERIOD_H_
+#define PERIOD_H_
+
+#include <stdint.h>
+
+#include "tfa.h"
+
+#define PER_FRAC 16 /* period fixed point scale [1/s] */
+#define PER_MIN 10 /* min interval of transmissions [s] (shorter are duplicates of one transmission) */
+#define PER_MAX 600 /* max period to estimate [s] */
+#define PER_AVG 8 /* period averaging (exponential, weight 1/PER_AVG) */
+#define PER_LISTEN 3 /* listen window half width around expected transmission [s] */
+
+typedef struct{
+	uint8_t id; /* tracked sensor ID (0xFF = none) */
+	uint16_t last; /* time of last transmission [s] */
+	uint16_t period; /* estimated period [1/PER_FRAC s], 0 = unknown */
+	uint16_t received; /* received transmissions */
+	uint16_t missed; /* missed expected transmissions */
+}TPeriod;
+
+
+// --- functions:
+void period_init(TPeriod *per);
+uint8_t period_update(TPeriod *per, TSensor *sensor, uint16_t time);
+uint16_t period_missed(TPeriod *per, uint16_t time);
+uint8_t period_listen(TPeriod *per, uint16_t time);
+
+
+#endif
@@ -2,12 +2,28 @@
 // Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
 // This module contains UART receiver ISR and SCPI command decoder.
 // 
-// UART data are received to ring buffer in ISR. 
-// serial_decode() checks and disects commands separated by LF or semicolon.
+// UART data are received to ring buffer in ISR. First RX_CMD_MAX bytes of
+// the ring are mirrored past its end, so any command up to RX_CMD_MAX bytes
+// is contiguous in memory regardless of wrap. serial_decode() checks and
+// disects commands separated by LF or semicolon in place (no copy), returns
+// pointers to command and parameter in the buffer which are valid until
+// serial_release() is called when the command is processed.
+// When the ring is full, the ISR drops the unfinished command and the rest
+// of its command chain up to LF, counts the loss and serial_decode() stores
+// SCPI error -363. Optional flow control (RX_FLOW) stops host before that
+// by XOFF or RTS and resumes it when commands are released.
+// Baud rate divisor is computed and checked at compile time (max 2% error).
+// Optional auto-baud (USART_AUTOBAUD) keeps UART receiver off and measures
+// the shortest low pulse of the first received byte 'U' (0x55, each low
+// pulse is one bit) by Timer1 in pin change ISR, then snaps the measured
+// rate to the nearest standard rate with divisor error within 2% for F_CPU.
+// Answers use USART_BAUDRATE until then.
 // Transmission is not in ISR. 
-// serial_error() function can hold SCPI style error string. Note it is 
-// using malloc() to hold eventual error message, so heap should not be used
-// anywhere else in the programm simultaneously.
+// serial_error() function holds SCPI style errors in static FIFO queue
+// (SCPI_ERR_QUEUE entries) read by SYST:ERR?. RAM string messages are
+// copied to fixed size entry buffer (truncated to SCPI_ERR_MAXBUF-1 chars),
+// progmem messages are stored by pointer. When the queue is full, the last
+// entry is replaced by -350 "Queue overflow" as SCPI requires.
 //
 // (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
 // url: https://github.com/smaslan/TFA-30321502-decoder
@@ -29,155 +45,374 @@
 #include "main.h"
 #include "serial.h"
 
-// rx data buffer
-char rxd[RX_BUF_SZ];
+// rx data buffer (ring of RX_BUF_SZ followed by mirror of its first RX_CMD_MAX bytes)
+char rxd[RX_BUF_SZ + RX_CMD_MAX];
 // rx data position
-volatile char *rxd_ptr;
-volatile char *rxd_read;
+volatile uint8_t rxd_write;
+volatile uint8_t rxd_read;
+volatile uint8_t rxd_cmd; // start of unfinished command
+// received commands count
+volatile uint8_t rxd_stat;
 // flags
-volatile int8_t rxd_stat;
+#define RX_OVERFLOW (1<<0) /* overflow occured (not reported yet) */
+#define RX_DISCARD (1<<1) /* dropping rest of command chain after overflow */
+#define RX_STOPPED (1<<2) /* host stopped by flow control */
+volatile uint8_t rxd_flags;
+// overflow events and dropped bytes
+uint16_t rxd_over;
+uint16_t rxd_lost;
+// pending flow control character to send (XON/XOFF mode)
+volatile char rxd_flow_tx;
+// currently decoded command: terminator and next command read position
+char rxd_term;
+uint8_t rxd_next;
 
 //----------------------------------------------------------------------------------
 // UART STUFF
 //----------------------------------------------------------------------------------
 
-void inline serial_fifo_wrap(char *buf,char **addr)
+static inline void serial_tx_flow(void);
+
+// stop host (flow control)
+static inline void serial_flow_stop(void)
 {
-	if(*addr >= &buf[RX_BUF_SZ])
-		*addr = &buf[0]; // wrap around buffer
+	rxd_flags |= RX_STOPPED;
+#if RX_FLOW == RX_FLOW_XONXOFF
+	rxd_flow_tx = XOFF;
+#elif RX_FLOW == RX_FLOW_RTS
+	sbi(RTS_PORT,RTS);
+#endif
 }
 
 // USART ISR
-ISR(USART0_RX_vect)
+ISR(HAL_USART_RX_vect)
 {
 	// reenable ISR, but it is a bit risky if not processed before next byte
 	//sei();
 
-	char *ptr = (char*)rxd_ptr; // work with local copy - faster
+	uint8_t wr = rxd_write; // work with local copy - faster
 	
 	// read byte
 	char dbyte = UDR0;
+
+#if RX_FLOW == RX_FLOW_XONXOFF
+	// ignore host's flow control
+	if(dbyte == XON || dbyte == XOFF)
+		return;
+#endif
+
+	if(rxd_flags & RX_DISCARD)
+	{
+		// overflow: drop rest of command chain
+		if(rxd_lost < 0xFFFFu)
+			rxd_lost++;
+		if(dbyte == '\n')
+			rxd_flags &= ~RX_DISCARD;
+		return;
+	}
+
+	uint8_t space = (rxd_read - wr - 1) & (RX_BUF_SZ-1);
+	if(!space)
+	{
+		// overflow: drop unfinished command (and rest of chain)
+		uint8_t lost = ((wr - rxd_cmd) & (RX_BUF_SZ-1)) + 1;
+		rxd_lost = (rxd_lost > 0xFFFFu - lost)?0xFFFFu:(rxd_lost + lost);
+		if(rxd_over < 0xFFFFu)
+			rxd_over++;
+		rxd_write = rxd_cmd;
+		rxd_flags |= RX_OVERFLOW;
+		if(dbyte != '\n')
+			rxd_flags |= RX_DISCARD;
+		return;
+	}
 	
-	// store data byte
-	*ptr++ = dbyte;
-	serial_fifo_wrap(rxd,&ptr);
-	*ptr = '\0';
+	// store data byte (and its mirror past the ring end)
+	rxd[wr] = dbyte;
+	if(wr < RX_CMD_MAX)
+		rxd[RX_BUF_SZ + wr] = dbyte;
+	wr = (wr + 1) & (RX_BUF_SZ-1);
 		
 	// detect command end
 	if(dbyte == '\n' || dbyte == ';')
+	{
 		rxd_stat++;
+		rxd_cmd = wr;
+	}
+
+	rxd_write = wr; // store back local write position
+
+	// stop host if buffer is getting full
+	if(RX_FLOW != RX_FLOW_NONE && space <= RX_FLOW_STOP && !(rxd_flags & RX_STOPPED))
+		serial_flow_stop();
+}
+
+// resume host if there is enough space in buffer (flow control)
+static void serial_flow_check(void)
+{
+#if RX_FLOW != RX_FLOW_NONE
+	if(!(rxd_flags & RX_STOPPED) || ((rxd_read - rxd_write - 1) & (RX_BUF_SZ-1)) < RX_FLOW_GO)
+		return;
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		rxd_flags &= ~RX_STOPPED;
+	#if RX_FLOW == RX_FLOW_XONXOFF
+		rxd_flow_tx = XON;
+	#else
+		cbi(RTS_PORT,RTS);
+	#endif
+	}
+#endif
+}
+
+// current baud rate [bd]
+uint32_t serial_baud;
+
+#if USART_AUTOBAUD
+// standard baud rates for auto-baud
+const uint32_t serial_bauds[] PROGMEM = {2400,4800,9600,14400,19200,28800,38400,57600,76800,115200,230400,250000};
+#define SERIAL_BAUDS (sizeof(serial_bauds)/sizeof(serial_bauds[0]))
 
-	rxd_ptr = ptr; // store back local write pointer
+// rounded divisor of baud rate plus one (double speed mode), 0 if out of range or error over 2% for F_CPU (see USART_BAUD_ERR)
+static uint16_t serial_ubrr(uint32_t baud)
+{
+	uint32_t div = (F_CPU + 4ul*baud)/(8ul*baud);
+	if(div < 1 || div > 4096)
+		return(0);
+	uint32_t err = (F_CPU/(8ul*div))*1000ul/baud;
+	if(err < 980 || err > 1020)
+		return(0);
+	return((uint16_t)div);
 }
 
+// auto-baud: RXD pin change ISR
+ISR(HAL_RXD_PCINT_vect)
+{
+	static uint16_t fall;
+	static uint16_t width;
+	static uint8_t edges = 0;
+	uint16_t time = TCNT1;
+
+	if(!(HAL_RXD_PIN & (1<<HAL_RXD)))
+	{
+		// low pulse start
+		fall = time;
+		return;
+	}
+	
+	// low pulse end: find shortest one
+	uint16_t dt = time - fall;
+	if(!edges || dt < width)
+		width = dt;
+	if(++edges < AB_EDGES)
+		return;
+
+	// done: snap to nearest standard rate usable with F_CPU (fall back to USART_BAUDRATE if none)
+	uint32_t baud = F_CPU/width;
+	uint32_t best = USART_BAUDRATE;
+	uint16_t best_ubrr = (uint16_t)USART_UBRR;
+	uint32_t best_dist = 0xFFFFFFFFul;
+	for(uint8_t k = 0;k < SERIAL_BAUDS;k++)
+	{
+		uint32_t std = pgm_read_dword(&serial_bauds[k]);
+		uint32_t dist = (baud > std)?(baud - std):(std - baud);
+		uint16_t ubrr = serial_ubrr(std);
+		if(ubrr && dist < best_dist)
+		{
+			best = std;
+			best_ubrr = ubrr - 1;
+			best_dist = dist;
+		}
+	}
+	serial_baud = best;
+	UBRR0 = best_ubrr;
+	
+	// disable detector, start receiver
+	HAL_RXD_PCMSK &= ~(1<<HAL_RXD_PCINT);
+	PCICR &= ~(1<<HAL_RXD_PCIE);
+	TCCR1B = 0;
+	UCSR0B |= (1<<RXCIE0) | (1<<RXEN0);
+}
+#endif
+
 // init USART
 void serial_init(void)
 {
 	// init RX/TX
 	UCSR0A = (1<<U2X0);
-	UCSR0B = (1<<RXCIE0) | (1<<RXEN0) | (1<<TXEN0);
 	UCSR0C = (0<<UMSEL00) | (0<<UPM00) | (0<<USBS0) | (3<<UCSZ00);
-	UBRR0 = (uint16_t)((F_CPU/(USART_BAUDRATE*8ul)) - 1);
+	UBRR0 = (uint16_t)USART_UBRR;
+	serial_baud = USART_BAUDRATE;
+#if USART_AUTOBAUD
+	// receiver waits for auto-baud detection
+	UCSR0B = (1<<TXEN0);
+	TCCR1A = 0;
+	TCCR1B = (1<<CS10); // XCLK/1 timestamps
+	HAL_RXD_PCMSK |= (1<<HAL_RXD_PCINT);
+	PCICR |= (1<<HAL_RXD_PCIE);
+#else
+	UCSR0B = (1<<RXCIE0) | (1<<RXEN0) | (1<<TXEN0);
+#endif
 
-	rxd[0] = '\0';
-	rxd_ptr = &rxd[0]; // write pointer
-	rxd_read = &rxd[0]; // read pointer
+	rxd_write = 0; // write position
+	rxd_read = 0; // read position
+	rxd_cmd = 0;
+	rxd_next = 0;
 	rxd_stat = 0; // no command yet
+	rxd_flags = 0;
+	rxd_over = 0;
+	rxd_lost = 0;
+	rxd_flow_tx = '\0';
+#if RX_FLOW == RX_FLOW_RTS
+	// RTS output, ready to receive
+	cbi(RTS_PORT,RTS);
+	sbi(RTS_DDR,RTS);
+#elif RX_FLOW == RX_FLOW_XONXOFF
+	rxd_flow_tx = XON;
+#endif
 }
 
-// decode command, supports following format:
+// is command terminator?
+#define serial_is_term(c) ((c) == ';' || (c) == '\n' || (c) == '\r')
+
+// decode command in place, supports following format:
 //  "my:command:or:whatever[<space(s)>parameter]"
-uint8_t serial_decode(char *cbuf,char **par)
+// returns 1 if command is available, call serial_release() when done with it
+uint8_t serial_decode(char **cmd,char **par)
 {
-	// check command completness
-	int8_t count = 0;
-	int8_t stat;
-	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	// report overflow
+	if(rxd_flags & RX_OVERFLOW)
 	{
-		stat = rxd_stat;
+		ATOMIC_BLOCK(ATOMIC_FORCEON)
+		{
+			rxd_flags &= ~RX_OVERFLOW;
+		}
+		serial_error(SCPI_ERR_inputOverrun,PSTR("Command chain dropped."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
 	}
+
+	// send pending flow control character
+	serial_tx_flow();
+
+	// check command completness
+	uint8_t stat = rxd_stat;
 	if(stat < 1)
 		return(0); // no command yet - get out
 	
-	// we have command in buffer - quickly copy it to secondary buffer
-	
-	// command buffer pointer
-	char *com = cbuf;
-	*com = '\0';
-
-	// rx buffer read pointer
-	char *ptr = (char*)rxd_read;
+	// skip empty commands and leftover terminators
+	uint8_t rd = rxd_read;
+	uint8_t count = 0;
+	char db;
+	while(stat > count && (serial_is_term(db = rxd[rd]) || db == ' '))
+	{
+		if(db == ';' || db == '\n')
+			count++;
+		rd = (rd + 1) & (RX_BUF_SZ-1);
+	}
+	stat -= count;
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		rxd_stat -= count;
+	}
+	rxd_read = rd;
+	serial_flow_check();
+	rxd_next = rd;
+	rxd_term = '\0';
+	if(stat < 1)
+		return(0); // nothing but empty commands
 
-	// no parameter detected yet
+	// find command end in linear (mirrored) view of buffer
+	char *com = &rxd[rd];
 	*par = NULL;
-
-	// end of command reached?
-	uint8_t is_end = 0;
-
-	while(1)
+	uint8_t len;
+	for(len = 0;len < RX_CMD_MAX && !serial_is_term(com[len]);len++)
 	{
-		// get RX byte
-		char db = *ptr;		
-
-		if(db == ' ' && !*par)
-		{
-			// parameter separator
-			*com++ = '\0';		
-
-			// return parameter poiner
-			*par = com;
-			
-			// skip parameter separator(s)
-			while(*ptr == ' ')
-			{
-				ptr++;
-				serial_fifo_wrap(rxd,&ptr);
-			}
-			
-			continue;			
-		}
-		else if(db == ';' || db == '\n' || db == '\r')
-		{
-			// update remainig events count
-			if(db != '\r')
-				count++;
-			
-			// end of command
-			if(!is_end)
-				*com++ = '\0';
-			
-			// end of command reached, but check if there is additional rubbish after
-			is_end = 1;			
-		}
-		else if(is_end)
+		if(com[len] == ' ' && !*par)
 		{
-			// end of command reached
-			rxd_read = ptr; // store next command read position
-			break;
+			// parameter separator(s)
+			com[len] = '\0';
+			while(len + 1 < RX_CMD_MAX && com[len + 1] == ' ')
+				len++;
+			*par = &com[len + 1];
 		}
-		else
+	}
+	if(len >= RX_CMD_MAX)
+	{
+		// too long: drop it up to terminator
+		while(!serial_is_term(rxd[rd]))
+			rd = (rd + 1) & (RX_BUF_SZ-1);
+		rxd_read = rd;
+		rxd_next = rd;
+		serial_flow_check();
+		serial_error(SCPI_ERR_headerTooLong,PSTR("Command too long."),SCPI_ERR_STORE|SCPI_ERR_PSTR);
+		return(0);
+	}
+	rxd_term = com[len];
+	com[len] = '\0';
+	if(*par && !**par)
+		*par = NULL; // trailing spaces only
+	rxd_next = (rd + len + 1) & (RX_BUF_SZ-1);
+	*cmd = com;
+	return(1);
+}
+
+// release command returned by serial_decode()
+void serial_release(void)
+{
+	rxd_read = rxd_next;
+	if(rxd_term == ';' || rxd_term == '\n')
+	{
+		ATOMIC_BLOCK(ATOMIC_FORCEON)
 		{
-			// copy command data
-			*com++ = db;
+			rxd_stat--;
 		}
-		
-		// move to next RX byte
-		ptr++;
-		serial_fifo_wrap(rxd,&ptr);
 	}
+	rxd_term = '\0';
+	serial_flow_check();
+}
 
-	// update new command events count
-	ATOMIC_BLOCK(ATOMIC_FORCEON)
+// get current baud rate [bd]
+uint32_t serial_get_baud(void)
+{
+	uint32_t baud;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		rxd_stat -= count;
+		baud = serial_baud;
+	}
+	return(baud);
+}
+
+// get overflow events and dropped bytes counts
+void serial_get_over(uint16_t *events,uint16_t *bytes)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*events = rxd_over;
+		*bytes = rxd_lost;
 	}
-	
-	return(cbuf[0] != '\0'); // command detected
+}
+
+// send pending flow control character (XON/XOFF mode)
+// note: ISR cannot send it itself without colliding with main loop transmission
+static inline void serial_tx_flow(void)
+{
+#if RX_FLOW == RX_FLOW_XONXOFF
+	if(rxd_flow_tx)
+	{
+		char flow;
+		ATOMIC_BLOCK(ATOMIC_FORCEON)
+		{
+			flow = rxd_flow_tx;
+			rxd_flow_tx = '\0';
+		}
+		loop_until_bit_is_set(UCSR0A,UDRE0);
+		UDR0 = flow;
+	}
+#endif
 }
 
 // send byte
 void serial_tx_byte(uint8_t byte)
 {
+	serial_tx_flow();
 	loop_until_bit_is_set(UCSR0A,UDRE0);
 	UDR0 = byte;
 }
@@ -213,70 +448,103 @@ void serial_tx_str(char *str)
 
 // --- SCPI error generator ---
 
+// SCPI error queue entry
+typedef struct{
+	int16_t err; /* error code */
+	const char *pinfo; /* PSTR info (or NULL) */
+	char info[SCPI_ERR_MAXBUF]; /* RAM string info copy (if pinfo is NULL) */
+}TScpiErr;
+
+// SCPI error queue
+TScpiErr err_queue[SCPI_ERR_QUEUE];
+uint8_t err_read;
+uint8_t err_count;
+
 // err: error code; info: optional error message; mode: flags
 void serial_error(int16_t err,const char *info,uint8_t mode)
 {
-	static uint16_t err_mem = 0;
-	static char *info_mem = NULL;
-	static uint8_t is_malloc = 0;
-	
-	// remember last error
+	if(mode&SCPI_ERR_CLEAR)
+	{
+		// clear queue
+		err_count = 0;
+	}
+
+	// store error to queue
 	if(mode&SCPI_ERR_STORE)
 	{
-		// loose old info buffer
-		if(is_malloc && info_mem)
-			free((void*)info_mem);
-		info_mem = NULL;
+		TScpiErr *entry;
+		if(err_count >= SCPI_ERR_QUEUE)
+		{
+			// queue full: replace last entry by overflow error
+			entry = &err_queue[(err_read + SCPI_ERR_QUEUE - 1)%SCPI_ERR_QUEUE];
+			err = SCPI_ERR_queueOverflow;
+			info = NULL;
+			mode &= ~SCPI_ERR_STR;
+		}
+		else
+			entry = &err_queue[(err_read + err_count++)%SCPI_ERR_QUEUE];
 
-		err_mem = err;
-		if(mode & SCPI_ERR_STR)
+		entry->err = err;
+		entry->pinfo = NULL;
+		entry->info[0] = '\0';
+		if(info && (mode & SCPI_ERR_STR))
 		{
-			// RAM string mode						
-			info_mem = (char*)malloc(strlen(info)+1);
-			strcpy(info_mem,info);
-			is_malloc = 1;
+			// RAM string mode
+			strncpy(entry->info,info,SCPI_ERR_MAXBUF-1);
+			entry->info[SCPI_ERR_MAXBUF-1] = '\0';
 		}
 		else
 		{
 			// PSTR mode
-			info_mem = (char*)info;
-			is_malloc = 0;
+			entry->pinfo = info;
 		}
 	}
 
+	// send oldest error from queue
 	if(mode&SCPI_ERR_SEND)
 	{
-		switch(err_mem)
+		if(!err_count)
+		{
+			serial_tx_cstr(PSTR("0, No error.\n"));
+			return;
+		}
+		TScpiErr *entry = &err_queue[err_read];
+		err_read = (err_read + 1)%SCPI_ERR_QUEUE;
+		err_count--;
+
+		switch(entry->err)
 		{
 			case SCPI_ERR_undefinedHeader:
 				serial_tx_cstr(PSTR("-113, Undefined command header.")); break;
+			case SCPI_ERR_headerTooLong:
+				serial_tx_cstr(PSTR("-112, Program mnemonic too long.")); break;
 			case SCPI_ERR_wrongParamType:
 				serial_tx_cstr(PSTR("-104, Wrong parameter type or value.")); break;
 			case SCPI_ERR_tooFewParameters:
 				serial_tx_cstr(PSTR("-109, Missing parameters.")); break;
 			case SCPI_ERR_std_mediaProtected:
 				serial_tx_cstr(PSTR("-258, EEPROM write protected.")); break;
-			case SCPI_ERR_noError:
-				serial_tx_cstr(PSTR("0, No error.")); break;
+			case SCPI_ERR_queueOverflow:
+				serial_tx_cstr(PSTR("-350, Queue overflow.")); break;
 			default:
+			{
+				char str[8];
+				itoa(entry->err,str,10);
+				serial_tx_str(str);
+				serial_tx_byte(',');
 				break;
-
+			}
+		}
+		if(entry->pinfo)
+		{
+			serial_tx_byte(' ');
+			serial_tx_cstr(entry->pinfo);
 		}
-		if(info_mem)
+		else if(entry->info[0])
 		{
 			serial_tx_byte(' ');
-			if(is_malloc)
-				serial_tx_str(info_mem);
-			else
-				serial_tx_cstr(info_mem);
+			serial_tx_str(entry->info);
 		}
 		serial_tx_cstr(PSTR("\n"));
-
-		// loose old info buffer
-		if(is_malloc && info_mem)
-			free((void*)info_mem);
-		info_mem = NULL;
-		err_mem = 0;		
 	}
-	
 }
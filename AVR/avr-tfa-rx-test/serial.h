@@ -15,32 +15,72 @@
 #define SERIAL_H
 
 // --- USART config ---
-#define USART_BAUDRATE 19200 /* baud rate (do not set too high!) */
-#define RX_BUF_SZ 128 /* receive buffer size (max 255!) */
+#ifndef USART_BAUDRATE
+	#define USART_BAUDRATE 19200 /* baud rate (max 38400 with internal 8 MHz RC, 115200+ needs crystal, e.g. 14.7456 MHz) */
+#endif
+#define USART_UBRR ((F_CPU + 4ul*USART_BAUDRATE)/(8ul*USART_BAUDRATE) - 1) /* rounded divisor (double speed mode) */
+#define USART_BAUD_REAL (F_CPU/(8ul*(USART_UBRR + 1))) /* actual baud rate [bd] */
+#define USART_BAUD_ERR ((USART_BAUD_REAL*1000ul)/USART_BAUDRATE) /* actual/desired baud rate [1/1000] */
+#if USART_UBRR > 4095 || USART_UBRR < 0
+	#error "USART_BAUDRATE out of range for F_CPU."
+#endif
+#if USART_BAUD_ERR < 980 || USART_BAUD_ERR > 1020
+	#error "USART_BAUDRATE error over 2% for F_CPU, choose other baud rate or crystal (e.g. 7.3728, 11.0592 or 14.7456 MHz)."
+#endif
+
+// auto-baud: measures first received byte 'U' (0x55) and snaps to standard rate usable with F_CPU (Timer1, pin change IRQ of RXD, see hal.h)
+#ifndef USART_AUTOBAUD
+	#define USART_AUTOBAUD 0 /* auto-baud enabled? */
+#endif
+#define AB_EDGES 5 /* low pulses of 'U' including start bit */
+#define RX_BUF_SZ 128 /* receive buffer size (power of 2, max 128!) */
+#define RX_CMD_MAX 64 /* max single command length including terminator (mirrored part of buffer) */
 #define RX_DONE 0 /* command received flag */
 
+// --- RX flow control (optional) ---
+#define RX_FLOW_NONE 0 /* no flow control */
+#define RX_FLOW_XONXOFF 1 /* software XON/XOFF sent to host (binary answers may contain them, prefer RTS with TFA:RAW) */
+#define RX_FLOW_RTS 2 /* hardware RTS output to host CTS (low = ready to receive) */
+#ifndef RX_FLOW
+	#define RX_FLOW RX_FLOW_NONE /* selected flow control */
+#endif
+#define RX_FLOW_STOP 32 /* stop host when free buffer space drops to this [B] (room for bridge FIFO) */
+#define RX_FLOW_GO 64 /* resume host when free buffer space rises to this [B] */
+#define XON 0x11
+#define XOFF 0x13
+// RTS output pin: see hal.h
+
 
 // --- SCPI errors ---
-// SCPI error info buffer size [B]
-#define SCPI_ERR_MAXBUF 64
+// SCPI error info buffer size per queue entry [B] (longer RAM strings are truncated)
+#define SCPI_ERR_MAXBUF 32
+// SCPI error queue depth (last entry turns to queue overflow error when full)
+#define SCPI_ERR_QUEUE 4
 
 // SCPI error flags
 #define SCPI_ERR_STORE 1 /* store error message to buffer */
 #define SCPI_ERR_SEND 2 /* send error from internal buffer */
 #define SCPI_ERR_PSTR 0 /* info is PSTR */
 #define SCPI_ERR_STR 4 /* info is RAM string */
+#define SCPI_ERR_CLEAR 8 /* clear error queue */
 
 // SCPI errors
 #define SCPI_ERR_noError 0l
 #define SCPI_ERR_undefinedHeader -113l
+#define SCPI_ERR_headerTooLong -112l
 #define SCPI_ERR_wrongParamType -104l
 #define SCPI_ERR_tooFewParameters -109l
 #define SCPI_ERR_std_mediaProtected -258l
+#define SCPI_ERR_queueOverflow -350l
+#define SCPI_ERR_inputOverrun -363l
 
 
 // --- prototypes ---
 void serial_init(void);
-uint8_t serial_decode(char *cbuf,char **par);
+uint8_t serial_decode(char **cmd,char **par);
+void serial_release(void);
+void serial_get_over(uint16_t *events,uint16_t *bytes);
+uint32_t serial_get_baud(void);
 void serial_tx_byte(uint8_t byte);
 void serial_tx_cstr(const char *str);
 void serial_tx_str(char *str);
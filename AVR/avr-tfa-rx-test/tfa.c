@@ -27,7 +27,37 @@
 // bits to local array. After successful reception it returns the data
 // to working buffer which is post processed in main program loop to not
 // delay the ISR. Note the receiver places bits to buffer in reverse order
-// to make parsing the data easier.
+// to make parsing the data easier. The packet assembler, election and
+// parser are hardware independent and live in tfa_core.c, so the host
+// tools can use the very same decoder.
+//
+// When two sensors transmit at once, the packets of both transmissions
+// (and corrupted ones from the overlap) end up in one reception. Therefore
+// the receiver keeps up to 14 packet slots and election clusters them by
+// content, so up to two sensors are decoded from one reception. Main loop
+// calls tfa_proc_packets() until all elected packets are processed.
+//
+// Up to 4 RX modules (different antennas or placement) can be connected
+// to ARX port for antenna diversity (build with TFA_INPUTS, pins ARX_MASK
+// see hal.h). All inputs are sampled by single port read and edges are
+// detected bit-parallel, each input feeds its own packet assembler.
+// Packets of all inputs ending within TFA_T_MERGE_US are pooled to one
+// election, so the repetitions clean on any input add up and the same
+// transmission is elected only once. Identical packets elected later
+// (input which received the transmission late) are dropped by content.
+//
+// Packet assembler also collects statistics of each transmission (glitches,
+// gap widths), which are used with election results to score link quality
+// of elected packets (see tfa_quality()).
+//
+// Glitch rejection can be relaxed in listen window around expected sensor
+// transmission (see period.c), so short dropouts inside pulses of weak
+// sensors do not kill the packet while noise is rejected the rest of time.
+//
+// Optionally the ISR streams durations of all edges of RX module output
+// in compact varint coding (see tfa_core.h) via ring buffer to main loop
+// which sends them to host (TFA:RAW mode), so AVR can serve as digitiser
+// for host side decoding.
 //
 // (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
 // url: https://github.com/smaslan/TFA-30321502-decoder
@@ -43,17 +73,40 @@
 #include <string.h>
 
 #include "tfa.h"
+#include "tfa_core.h"
 #include "main.h"
 
 // received data pointer
 TTFA *p_tfa;
 
+// packet assemblers (one per input)
+static TTFARx tfa_rx[TFA_INPUTS];
+
+#if ARX_INPUTS != TFA_INPUTS
+	#error "ARX_MASK must have TFA_INPUTS pins (see hal.h)."
+#endif
+#define ARX_RAW ((ARX_MASK) & -(ARX_MASK)) /* input of raw edge stream (first of ARX_MASK) */
+
+// time base [s]
+uint16_t tfa_seconds;
+
+// low-pulse width histogram [ticks]
+uint16_t tfa_hist[TFA_HIST_BINS];
+
+// raw edge stream ring buffer
+uint8_t tfa_raw[TFA_RAW_BUF];
+volatile uint8_t tfa_raw_wr;
+volatile uint8_t tfa_raw_rd;
+// lost edges count and pending lost edges marker
+uint16_t tfa_raw_lost;
+uint8_t tfa_raw_lost_mark;
+
 // initialize TFA decoder
 void tfa_init(TTFA *tfa)
 {
-	// RX module input (no pullup)
-	cbi(ARX_DDR,ARX);
-	cbi(ARX_PORT,ARX);
+	// RX module inputs (no pullup)
+	ARX_DDR &= ~ARX_MASK;
+	ARX_PORT &= ~ARX_MASK;
 
 	// data indicator LED
 	sbi(LED_PACKET_DDR,LED_PACKET);
@@ -65,8 +118,48 @@ void tfa_init(TTFA *tfa)
 	TIMSK0 |= (1<<OCIE0A);
 
 	// reset TFA receiver
+	for(uint8_t k = 0;k < TFA_INPUTS;k++)
+		tfa_rx_init(&tfa_rx[k]);
 	p_tfa = tfa;
 	p_tfa->flags = 0;
+	p_tfa->cands = 0;
+	tfa_hist_clear();
+	tfa_raw_mode(tfa,0);
+	tfa_early_mode(tfa,0,0);
+}
+
+// store byte to raw edge stream ring (no check)
+#define tfa_raw_put(wr,byte) {tfa_raw[wr] = (byte); wr = (wr + 1) & (TFA_RAW_BUF-1);}
+
+// push raw edge symbol to ring buffer (ISR only)
+static inline void tfa_raw_push(uint8_t ticks, uint8_t is_high)
+{
+	uint8_t wr = tfa_raw_wr;
+	uint8_t space = (tfa_raw_rd - wr - 1) & (TFA_RAW_BUF-1);
+	if(space < (tfa_raw_lost_mark?4:2))
+	{
+		// no space for worst case symbol: drop edge
+		if(tfa_raw_lost < 0xFFFFu)
+			tfa_raw_lost++;
+		tfa_raw_lost_mark = 1;
+		return;
+	}
+	if(tfa_raw_lost_mark)
+	{
+		// let host know some edges are missing
+		tfa_raw_put(wr,TFA_RAW_MORE|TFA_RAW_HIGH|TFA_RAW_MASK);
+		tfa_raw_put(wr,TFA_RAW_LOST);
+		tfa_raw_lost_mark = 0;
+	}
+	uint8_t code = (ticks & TFA_RAW_MASK) | (is_high?TFA_RAW_HIGH:0);
+	if(ticks > TFA_RAW_MASK)
+	{
+		tfa_raw_put(wr,code|TFA_RAW_MORE);
+		tfa_raw_put(wr,ticks>>6);
+	}
+	else
+		tfa_raw_put(wr,code);
+	tfa_raw_wr = wr;
 }
 
 // TFA decoder tick ISR ---
@@ -75,10 +168,10 @@ ISR(TIMER0_COMPA_vect)
 	static uint16_t led_delay = 0;
 	static uint8_t tfa_old = 0x00;	
 
-	// sampling radio RX data
-	uint8_t tfa_state = ARX_PIN&(1<<ARX);
+	// sampling radio RX data (all inputs at once)
+	uint8_t tfa_state = ARX_PIN&ARX_MASK;
 
-	// detect changes
+	// detect changes (bit-parallel for all inputs)
 	uint8_t tfa_edge = tfa_state^tfa_old;
 	uint8_t tfa_fall = tfa_edge&tfa_old;
 	uint8_t tfa_rise = tfa_edge&tfa_state;
@@ -86,80 +179,101 @@ ISR(TIMER0_COMPA_vect)
 	// store old state
 	tfa_old = tfa_state;
 
-	// low-pulse duration timer
-	static uint8_t tfa_timer = 0;
-
-	static uint8_t tfa_buf[TFA_PACKETS][TFA_BUF_BYTES];
-	static int8_t tfa_buf_bit = 0;
-	static uint8_t tfa_buf_packet = 0;
+	// low-pulse duration timers
+	static uint8_t tfa_timer[TFA_INPUTS];
 
-	if(tfa_fall)
+	// raw edge stream duration timer (first input only)
+	static uint8_t tfa_raw_timer = 0;
+	if((tfa_edge & ARX_RAW) && (p_tfa->flags & TFA_RAW))
 	{
-		// pulse start: reset pulse timer
-		tfa_timer = 0;
+		// raw mode: stream duration of ended level
+		tfa_raw_push(tfa_raw_timer,!!(tfa_fall & ARX_RAW));
+		tfa_raw_timer = 0;
 	}
-	else if(tfa_rise)
+	if(tfa_raw_timer < 255)
+		tfa_raw_timer++;
+
+	// packets pooled from all inputs (statistics of input with most packets) and merge window timer
+	static uint8_t pool = 0;
+	static uint8_t pool_best = 0;
+	static uint16_t merge_timer = 0;
+
+	uint8_t k = 0;
+	for(uint8_t rest = ARX_MASK;rest && tfa_edge;rest &= rest - 1,k++)
 	{
-		// pulse end: decode
-		if(TFA_IS_GLITCH(tfa_timer))
+		uint8_t bit = rest & -rest;
+		if(tfa_fall & bit)
 		{
-			// glitch pulse - reject
-			tfa_buf_bit = -1;
-		}
-		else if(TFA_IS_STOP(tfa_timer))
-		{			
-			// stop bit - packet end			
-			if(tfa_buf_bit == 0)
-			{								
-				// full packet received
-				tfa_buf_bit--;
-				if(tfa_buf_packet < TFA_PACKETS+1)
-					tfa_buf_packet++;
-			}			
+			// pulse start: reset pulse timer
+			tfa_timer[k] = 0;
 		}
-		else if(TFA_IS_GAP(tfa_timer))
+		else if(tfa_rise & bit)
 		{
-			// end of transmission: copy data to destination buffer (processing is offloaded to main loop to save ISR time)
-			if(tfa_buf_packet >= 3 && tfa_buf_packet <= TFA_PACKETS)
-			{				
-				//serial_tx_byte(tfa_buf_packet);
-				memcpy((void*)p_tfa->data,(void*)tfa_buf,TFA_PACKETS*TFA_BUF_BYTES);
-				p_tfa->packets = tfa_buf_packet;
-				p_tfa->flags |= TFA_NEW_PACKETS;				
+			// pulse end: update low-pulse width histogram (if enabled)
+			if((p_tfa->flags & TFA_HIST) && tfa_hist[tfa_timer[k]] < 0xFFFFu)
+				tfa_hist[tfa_timer[k]]++;
+
+			// decode
+			uint8_t packets = tfa_rx_pulse(&tfa_rx[k],tfa_timer[k]);
+			if(packets & TFA_RX_EARLY)
+			{
+				// enough identical repetitions: pass last packet right away
+				packets &= ~TFA_RX_EARLY;
+				memcpy((void*)p_tfa->early,(void*)&tfa_rx[k].buf[packets - 1][0],TFA_BUF_BYTES);
+				memcpy((void*)&p_tfa->early_stat,(void*)&tfa_rx[k].stat,sizeof(TTFAStat));
+				p_tfa->early_count = packets;
+				p_tfa->flags |= TFA_NEW_EARLY;
 				// new packet LED pulse
 				led_delay = 0;
 				sbi(LED_PACKET_PORT,LED_PACKET);
 			}
-			// restart receiver
-			tfa_buf_packet = 0;			
+			else if(packets)
+			{
+				// end of transmission: pool packets of all inputs ending within merge window
+				if(!pool)
+				{
+					merge_timer = TFA_N_MERGE;
+					p_tfa->flags &= ~TFA_NEW_PACKETS;
+					pool_best = 0;
+				}
+				if(packets > pool_best)
+				{
+					memcpy((void*)&p_tfa->stat,(void*)&tfa_rx[k].stat,sizeof(TTFAStat));
+					pool_best = packets;
+				}
+				packets = min(packets,TFA_POOL - pool);
+				memcpy((void*)&p_tfa->data[pool][0],(void*)tfa_rx[k].buf,packets*TFA_BUF_BYTES);
+				pool += packets;
+			}
 		}
-		else if(TFA_IS_START(tfa_timer))
-		{									
-			// start bit		
-			tfa_buf_bit = TFA_BITS;
-			if(tfa_buf_packet < TFA_PACKETS)
-				tfa_buf[tfa_buf_packet][TFA_BUF_BYTES-1] = 0x00; // clear last unfull byte of packet
-		}		
+	}
+	for(k = 0;k < TFA_INPUTS;k++)
+		if(tfa_timer[k] < 255)
+			tfa_timer[k]++;
+
+	if(pool)
+	{
+		if(merge_timer)
+			merge_timer--;
 		else
 		{
-			// data bit - place to buffer			
-			if(tfa_buf_bit > 0 && tfa_buf_packet < TFA_PACKETS)
-			{				
-				tfa_buf_bit--;
-				uint8_t data = TFA_IS_HIGH(tfa_timer);
-				uint8_t bit = 1<<(tfa_buf_bit&0x07u);
-				uint8_t *byte = &tfa_buf[tfa_buf_packet][tfa_buf_bit>>3];
-				*byte = *byte & ~bit;
-				if(data)				
-					*byte |= bit;
-			}
-			else if(tfa_buf_bit >= 0)
-				tfa_buf_bit--;
+			// end of merge window: pass packets to main loop (processing is offloaded to main loop to save ISR time)
+			p_tfa->packets = pool;
+			p_tfa->flags |= TFA_NEW_PACKETS;
+			pool = 0;
+			// new packet LED pulse
+			led_delay = 0;
+			sbi(LED_PACKET_PORT,LED_PACKET);
 		}
+	}
 
-	}		
-	if(tfa_timer < 255)
-		tfa_timer++;
+	// seconds time base
+	static uint16_t sec_ticks = 0;
+	if(++sec_ticks >= TFA_SECOND)
+	{
+		sec_ticks = 0;
+		tfa_seconds++;
+	}
 
 	// delayed LED indicator
 	led_delay++;
@@ -167,77 +281,200 @@ ISR(TIMER0_COMPA_vect)
 		cbi(LED_PACKET_PORT,LED_PACKET);
 }
 
-// process received packets to final data
-// note: this must be called outside ISR to not block it as it is time consuming
-uint8_t tfa_proc_packets(TTFA *tfa)
+// clear low-pulse width histogram
+void tfa_hist_clear(void)
 {
-	if(!(tfa->flags & TFA_NEW_PACKETS))
-		return(0);
-	// some packet available
-	
-	// make atomic copy (to not disturb and be disturbed by receiver ISR)
-	uint8_t buf[TFA_PACKETS][TFA_BUF_BYTES];
-	uint8_t packets;
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		memcpy((void*)buf,(void*)tfa->data,TFA_PACKETS*TFA_BUF_BYTES);	
-		packets = tfa->packets;
-		tfa->flags &= ~TFA_NEW_PACKETS;
+		memset((void*)tfa_hist,0,sizeof(tfa_hist));
 	}
+}
 
-	// go through all received packets and find the one with most repetitions
-	int8_t counts[TFA_PACKETS];
-	memset((void*)counts,0,TFA_PACKETS);
-	int8_t maxv[2] = {0,0};
-	int8_t maxid = 0;	
-	for(uint8_t m = 0;m < packets;m++)
+// get low-pulse width histogram bin (atomic read as ISR may update it)
+uint16_t tfa_hist_get(uint8_t bin)
+{
+	uint16_t count;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		if(counts[m] != 0)
-			continue;
-		for(uint8_t n = 0;n < packets;n++)
-		{
-			if(counts[n] == 0 && !memcmp((void*)&buf[m][0],(void*)&buf[n][0],TFA_BUF_BYTES))
-			{
-				counts[m]++;
-				if(counts[m] > maxv[0])
-				{
-					// detect packet with maximum repetitions
-					maxv[1] = maxv[0];
-					maxv[0] = counts[m];
-					maxid = m;
-				}
-				if(counts[n])
-					counts[n] = -1;
-			}
-		}
+		count = tfa_hist[bin];
 	}
-	if(maxv[0] == maxv[1])
+	return(count);
+}
+
+// enable/disable raw edge streaming (resets stream buffer and lost edges counter)
+void tfa_raw_mode(TTFA *tfa, uint8_t enable)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		// cannot decide most common packet data
+		tfa_raw_wr = 0;
+		tfa_raw_rd = 0;
+		tfa_raw_lost = 0;
+		tfa_raw_lost_mark = 0;
+		tfa->flags &= ~TFA_RAW;
+		if(enable)
+			tfa->flags |= TFA_RAW;
+	}
+}
+
+// get byte from raw edge stream, returns 0 if stream is empty
+uint8_t tfa_raw_pop(uint8_t *byte)
+{
+	uint8_t rd = tfa_raw_rd;
+	if(rd == tfa_raw_wr)
 		return(0);
+	*byte = tfa_raw[rd];
+	tfa_raw_rd = (rd + 1) & (TFA_RAW_BUF-1);
+	return(1);
+}
+
+// get raw edge stream lost edges count
+uint16_t tfa_raw_get_lost(void)
+{
+	uint16_t count;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		count = tfa_raw_lost;
 	}
-	// finally select the correct packet
-	memcpy((void*)tfa->packet,(void*)&buf[maxid][0],TFA_BUF_BYTES);
+	return(count);
+}
 
+// set early accept after reps identical consecutive repetitions (0 to disable), suppress duplicates of early accepted packet?
+void tfa_early_mode(TTFA *tfa, uint8_t reps, uint8_t suppress)
+{
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		tfa->flags |= TFA_NEW_PACKET;
+		for(uint8_t k = 0;k < TFA_INPUTS;k++)
+			tfa_rx[k].early = reps;
+		tfa->passes = 0;
+		tfa->recents = 0;
+		tfa->flags &= ~(TFA_NEW_EARLY | TFA_EARLY_SUPP);
+		if(suppress)
+			tfa->flags |= TFA_EARLY_SUPP;
 	}
-	return(1);
 }
 
-// parse packet data to sensor struct
-uint8_t tfa_parse(TTFA *tfa, TSensor *sensor)
+// get early accept repetitions (0 if disabled)
+uint8_t tfa_early_get(void)
 {
-	sensor->rh = tfa->packet[0];	
-	uint16_t temp = *((uint16_t*)&tfa->packet[1]) & 0x0FFFu;
-	if(temp&0x0800u)
-		temp |= 0xF000u;
-	sensor->temp = 0.1*(float)*(int16_t*)&temp;
-	sensor->channel = 1 + ((tfa->packet[2]>>4)&0x03);
-	sensor->id = tfa->packet[3] & 0x0F;
-	sensor->type = (uint8_t)(*((uint16_t*)&tfa->packet[3]) >> 4);
-	sensor->flags = TFA_NEW_PACKET | (tfa->packet[2] & (TFA_LOW_BATT | TFA_SYNC));
-	return(sensor->type == TFA_TYPE);
+	return(tfa_rx[0].early);
 }
 
+// enable/disable listen window (relaxed glitch rejection while sensor transmission is expected)
+void tfa_listen(uint8_t enable)
+{
+	for(uint8_t k = 0;k < TFA_INPUTS;k++)
+		tfa_rx[k].listen = enable;
+}
+
+// get time base [s] (wraps after 65536 s)
+uint16_t tfa_time(void)
+{
+	uint16_t time;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		time = tfa_seconds;
+	}
+	return(time);
+}
+
+// is packet in list of packets?
+static uint8_t tfa_is_listed(uint8_t list[][TFA_BUF_BYTES], uint8_t count, uint8_t *packet)
+{
+	for(uint8_t m = 0;m < count;m++)
+		if(!memcmp((void*)&list[m][0],(void*)packet,TFA_BUF_BYTES))
+			return(1);
+	return(0);
+}
+
+// process received packets to final data, returns 1 for each new elected packet (call until it returns 0)
+// note: this must be called outside ISR to not block it as it is time consuming
+uint8_t tfa_proc_packets(TTFA *tfa)
+{
+	uint16_t time = tfa_time();
+	if(TFA_INPUTS > 1 && (uint16_t)(time - tfa->recent_time) > TFA_MERGE_S)
+	{
+		// merge window of other inputs is over
+		tfa->passes = 0;
+		tfa->recents = 0;
+	}
+
+	if(tfa->flags & TFA_NEW_EARLY)
+	{
+		// early accepted packet: pass it without waiting for end of transmission
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			memcpy((void*)tfa->packet,(void*)tfa->early,TFA_BUF_BYTES);
+			tfa->flags &= ~TFA_NEW_EARLY;
+		}
+		// pass only once per reception (other inputs or repeated runs of identical repetitions)
+		if(!tfa_is_listed(tfa->passed,tfa->passes,tfa->packet))
+		{
+			// link quality so far (repetitions before the identical ones disagree)
+			tfa->quality = tfa_quality(tfa_rx[0].early,tfa->early_count,tfa->early_count - tfa_rx[0].early,&tfa->early_stat);
+			// remember it to suppress its duplicate at the end of reception
+			if(tfa->passes < TFA_CANDIDATES)
+				memcpy((void*)&tfa->passed[tfa->passes++][0],(void*)tfa->packet,TFA_BUF_BYTES);
+			goto new_packet;
+		}
+	}
+
+	if(!tfa->cands)
+	{
+		if(!(tfa->flags & TFA_NEW_PACKETS))
+			return(0);
+		// some packets available
+
+		// make atomic copy (to not disturb and be disturbed by receiver ISR)
+		uint8_t buf[TFA_POOL][TFA_BUF_BYTES];
+		uint8_t packets;
+		TTFAStat stat;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			packets = tfa->packets;
+			memcpy((void*)buf,(void*)tfa->data,packets*TFA_BUF_BYTES);
+			memcpy((void*)&stat,(void*)&tfa->stat,sizeof(TTFAStat));
+			tfa->flags &= ~TFA_NEW_PACKETS;
+		}
+
+		// select the most common packets (up to two overlapping sensors)
+		uint8_t cands = tfa_elect(buf,packets,tfa->cand);
+
+		// remove packets already passed by early accept or elected from other input
+		tfa->cands = 0;
+		for(uint8_t k = 0;k < cands;k++)
+		{
+			uint8_t *cand = &tfa->cand[k][0];
+			if((tfa->flags & TFA_EARLY_SUPP) && tfa_is_listed(tfa->passed,tfa->passes,cand))
+				continue;
+			if(TFA_INPUTS > 1 && tfa_is_listed(tfa->recent,tfa->recents,cand))
+				continue;
+			tfa->cand_q[tfa->cands] = tfa_link_quality(buf,packets,cand,&stat);
+			memmove((void*)&tfa->cand[tfa->cands++][0],(void*)cand,TFA_BUF_BYTES);
+		}
+		if(TFA_INPUTS == 1)
+			tfa->passes = 0;
+		else if(tfa->cands)
+		{
+			// remember elected packets to merge late receptions of other inputs
+			memcpy((void*)tfa->recent,(void*)tfa->cand,tfa->cands*TFA_BUF_BYTES);
+			tfa->recents = tfa->cands;
+		}
+		if(!tfa->cands)
+			return(0);
+	}
+
+	// pass next elected packet
+	memcpy((void*)tfa->packet,(void*)&tfa->cand[0][0],TFA_BUF_BYTES);
+	tfa->quality = tfa->cand_q[0];
+	tfa->cands--;
+	memmove((void*)&tfa->cand[0][0],(void*)&tfa->cand[1][0],tfa->cands*TFA_BUF_BYTES);
+	memmove((void*)&tfa->cand_q[0],(void*)&tfa->cand_q[1],tfa->cands);
+
+	new_packet:
+	tfa->recent_time = time;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		tfa->flags |= TFA_NEW_PACKET;
+	}
+	return(1);
+}
@@ -13,44 +13,144 @@
 #ifndef TFA_H_
 #define TFA_H_
 
-// TFA sampling tick:
-#define TFA_TICK 50e-6 /* desired TICK rate [s] */
-#define TFA_TIMER ((int)(TFA_TICK*F_CPU/8.0) - 1) /* timer divisor for the tick */
-#define TFA_TICK_REAL (8.0*((int)TFA_TIMER+1)/F_CPU) /* actual tick rate after timer divisor rounding [s] */
-
-#define LED_DELAY (0.25/TFA_TICK_REAL) /* LED indication duration in ticks */
-
-// TFA 30.3215.02 timing:
-#define TFA_T_SHORT 1.8e-3 /* short-low pulse (low state) [s] */
-#define TFA_T_LONG 3.6e-3 /* long-low pulse (high state) [s] */
-#define TFA_T_MID (0.5*(TFA_T_SHORT + TFA_T_LONG)) /* decision rule between low/high pulse [s] */
-#define TFA_T_START (5e-3) /* start-low pulse decision rule [s] */
-#define TFA_T_STOP (0.75*TFA_T_SHORT) /* stop-low pulse decision rule [s] */
-#define TFA_T_GAP (10e-3) /* gap to signalize end of transmission [s] */
-#define TFA_T_GLITCH (0.2e-3) /* glitch limit to reject pulse [s] */
+// TFA sampling tick (timer 0, XCLK/8):
+#define TFA_TICK_US 50 /* desired TICK rate [us] */
+#define TFA_TIMER ((F_CPU/8ul*TFA_TICK_US + 500000ul)/1000000ul - 1) /* timer divisor for the tick */
+#define TFA_TICK_REAL (8.0*(TFA_TIMER + 1)/F_CPU) /* actual tick rate after timer divisor rounding [s] (host tools) */
+
+// time [us] to ticks, rounded down/up (integers evaluated by preprocessor/compiler, no float at runtime)
+#define TFA_TICK_DIV (8000000ull*(TFA_TIMER + 1))
+#define TFA_TICKS_FLOOR(us) (((us)*1ull*F_CPU)/TFA_TICK_DIV)
+#define TFA_TICKS_CEIL(us) (((us)*1ull*F_CPU + TFA_TICK_DIV - 1)/TFA_TICK_DIV)
+
+#define LED_DELAY TFA_TICKS_FLOOR(250000ul) /* LED indication duration in ticks */
+#define TFA_SECOND TFA_TICKS_FLOOR(1000000ul) /* ticks per second of time base */
+
+// RX modules (inputs) for antenna diversity (1-4, pins see hal.h)
+#ifndef TFA_INPUTS
+	#define TFA_INPUTS 1
+#endif
+#if TFA_INPUTS < 1 || TFA_INPUTS > 4
+	#error "TFA_INPUTS must be 1 to 4."
+#endif
+
+// TFA 30.3215.02 timing [us]:
+#define TFA_T_SHORT_US 1800 /* short-low pulse (low state) */
+#define TFA_T_LONG_US 3600 /* long-low pulse (high state) */
+#define TFA_T_MID_US ((TFA_T_SHORT_US + TFA_T_LONG_US)/2) /* decision rule between low/high pulse */
+#define TFA_T_START_US 5000 /* start-low pulse decision rule */
+#define TFA_T_STOP_US (3*TFA_T_SHORT_US/4) /* stop-low pulse decision rule */
+#define TFA_T_GAP_US 10000 /* gap to signalize end of transmission */
+#define TFA_T_GLITCH_US 200 /* glitch limit to reject pulse */
+#define TFA_T_GLITCH_LISTEN_US 100 /* relaxed glitch limit in listen window around expected transmission */
+#define TFA_T_MERGE_US 250000ul /* window to pool receptions of all inputs to one election (antenna diversity) */
+// the same in [s] (host tools)
+#define TFA_T_SHORT (1e-6*TFA_T_SHORT_US)
+#define TFA_T_LONG (1e-6*TFA_T_LONG_US)
+#define TFA_T_GLITCH (1e-6*TFA_T_GLITCH_US)
+// TFA decision thresholds [ticks] (rounded so integer compare equals compare with exact time)
+#define TFA_N_GLITCH TFA_TICKS_CEIL(TFA_T_GLITCH_US)
+#define TFA_N_GLITCH_LISTEN TFA_TICKS_CEIL(TFA_T_GLITCH_LISTEN_US)
+#define TFA_N_STOP TFA_TICKS_CEIL(TFA_T_STOP_US)
+#define TFA_N_MID TFA_TICKS_CEIL(TFA_T_MID_US)
+#define TFA_N_START TFA_TICKS_FLOOR(TFA_T_START_US)
+#define TFA_N_GAP TFA_TICKS_FLOOR(TFA_T_GAP_US)
+#define TFA_N_MERGE ((TFA_INPUTS > 1)?TFA_TICKS_FLOOR(TFA_T_MERGE_US):0)
 // TFA decision macros
-#define TFA_IS_GLITCH(ticks) (ticks < TFA_T_GLITCH/TFA_TICK_REAL) /* is pulse glitch? */
-#define TFA_IS_STOP(ticks) (ticks < TFA_T_STOP/TFA_TICK_REAL) /* is pulse start bit? */
-#define TFA_IS_LOW(ticks) (ticks < TFA_T_MID/TFA_TICK_REAL) /* is pulse low state? */
-#define TFA_IS_HIGH(ticks) (ticks >= TFA_T_MID/TFA_TICK_REAL) /* is pulse high state? */
-#define TFA_IS_START(ticks) (ticks > TFA_T_START/TFA_TICK_REAL) /* is pulse start bit? */
-#define TFA_IS_GAP(ticks) (ticks > TFA_T_GAP/TFA_TICK_REAL) /* is pulse end of transmission? */
+#define TFA_IS_GLITCH(ticks) ((ticks) < (uint8_t)TFA_N_GLITCH) /* is pulse glitch? */
+#define TFA_IS_GLITCH_LISTEN(ticks) ((ticks) < (uint8_t)TFA_N_GLITCH_LISTEN) /* is pulse glitch in listen window? */
+#define TFA_IS_STOP(ticks) ((ticks) < (uint8_t)TFA_N_STOP) /* is pulse stop bit? */
+#define TFA_IS_LOW(ticks) ((ticks) < (uint8_t)TFA_N_MID) /* is pulse low state? */
+#define TFA_IS_HIGH(ticks) ((ticks) >= (uint8_t)TFA_N_MID) /* is pulse high state? */
+#define TFA_IS_START(ticks) ((ticks) > (uint8_t)TFA_N_START) /* is pulse start bit? */
+#define TFA_IS_GAP(ticks) ((ticks) > (uint8_t)TFA_N_GAP) /* is pulse end of transmission? */
+
+// configuration checks
+#if TFA_TIMER < 1 || TFA_TIMER > 255
+	#error "TFA_TICK_US does not fit 8-bit timer 0 at F_CPU."
+#endif
+#if !(TFA_N_GLITCH_LISTEN <= TFA_N_GLITCH && TFA_N_GLITCH < TFA_N_STOP && TFA_N_STOP < TFA_N_MID && TFA_N_MID <= TFA_N_START && TFA_N_START < TFA_N_GAP && TFA_N_GAP < 255)
+	#error "TFA pulse classes are not separable with 8-bit pulse timer for TFA_TICK_US (must hold GLITCH_LISTEN <= GLITCH < STOP < MID <= START < GAP < 255 ticks)."
+#endif
+#if LED_DELAY > 65535 || TFA_SECOND > 65535 || TFA_N_MERGE > 65535
+	#error "LED_DELAY, TFA_SECOND or TFA_N_MERGE does not fit 16-bit counter, increase TFA_TICK_US."
+#endif
 
 // TFA 30.3215.02 packet setup
 #define TFA_BITS 36 /* single packet bits count */
 #define TFA_BUF_BYTES 5 /* single packet buffer bytes */
-#define TFA_PACKETS 7 /* TFA packets count */
+#define TFA_PACKETS 7 /* TFA packets count (repetitions in one transmission) */
+#define TFA_SLOTS 14 /* received packets buffer slots (room for two overlapping transmissions) */
+#define TFA_POOL (TFA_SLOTS*TFA_INPUTS) /* packet slots of reception pooled from all inputs */
+#define TFA_MERGE_S 2 /* identical packets elected within this time [s] are duplicates from other inputs */
+#define TFA_CANDIDATES 2 /* max elected packets (sensors) from one reception */
+#define TFA_MIN_REPS 2 /* min identical repetitions to elect packet */
 #define TFA_TYPE 0x90 /* TFA 30.3215.02 type id (probably) */
 
+// packet fields (bit position, width) of little endian packet word, bit 0 is the last transmitted
+//  note: each field must fit 16-bit window of two consecutive bytes (see TFA_FIELD())
+#define TFA_F_RH 0,8 /* relative humidity [%] */
+#define TFA_F_TEMP 8,12 /* temperature [0.1 degC], two's complement */
+#define TFA_F_FLAGS 16,8 /* flags byte (TFA_SYNC, TFA_LOW_BATT) */
+#define TFA_F_CHANNEL 20,2 /* channel - 1 */
+#define TFA_F_ID 24,4 /* sensor id (random after battery change) */
+#define TFA_F_TYPE 28,8 /* sensor type (TFA_TYPE) */
+
+// extract packet field fld (TFA_F_*) from packet bytes (no aligned or multibyte loads, constant shifts and mask)
+#define TFA_FIELD(pkt,fld) TFA_FIELD_(pkt,fld)
+#define TFA_FIELD_(pkt,pos,width) (((uint16_t)((pkt)[(pos)>>3] | (uint16_t)(pkt)[((pos)>>3)+1]<<8) >> ((pos)&7)) & ((1u<<(width))-1u))
+// place value to packet field fld of 64-bit packet word
+#define TFA_FIELD_WORD(fld,value) TFA_FIELD_WORD_(fld,value)
+#define TFA_FIELD_WORD_(pos,width,value) ((uint64_t)((value) & ((1u<<(width))-1u)) << (pos))
+
+// link quality score (0-100%, see tfa_quality())
+#define TFA_Q_DISAGREE 10 /* penalty per repetition disagreeing with elected packet */
+#define TFA_Q_GLITCH 2 /* penalty per glitch during transmission */
+#define TFA_Q_JITTER_US 10 /* penalty 1 per this std. deviation of gap widths [us] */
+
+// statistics of single transmission (link quality)
+typedef struct{
+	uint8_t glitches; /* rejected glitches during transmission */
+	uint8_t n[2]; /* gaps count of short/long class (low/high bits of complete packets among first TFA_PACKETS) */
+	uint16_t sum[2]; /* sum of gap widths [ticks] */
+	uint32_t sum2[2]; /* sum of squared gap widths [ticks^2] */
+}TTFAStat;
+
 #define TFA_NEW_PACKETS (1<<0) /* new packets received */
 #define TFA_NEW_PACKET (1<<1) /* new processed packet available */
+#define TFA_HIST (1<<2) /* pulse width histogram accumulation enabled */
+#define TFA_RAW (1<<3) /* raw edge streaming enabled */
+#define TFA_NEW_EARLY (1<<4) /* new early accepted packet */
+#define TFA_EARLY_SUPP (1<<5) /* suppress final packets of reception identical to early accepted ones */
 typedef struct{
-	uint8_t data[TFA_PACKETS][TFA_BUF_BYTES];
+	uint8_t data[TFA_POOL][TFA_BUF_BYTES];
 	uint8_t packets;
+	TTFAStat stat; /* statistics of reception */
+	uint8_t cand[TFA_CANDIDATES][TFA_BUF_BYTES]; /* elected packets waiting for processing */
+	uint8_t cand_q[TFA_CANDIDATES]; /* link quality of elected packets */
+	uint8_t cands;
+	uint8_t early[TFA_BUF_BYTES]; /* early accepted packet (from ISR) */
+	TTFAStat early_stat; /* statistics of reception until early accept */
+	uint8_t early_count; /* received packets until early accept */
+	uint8_t passed[TFA_CANDIDATES][TFA_BUF_BYTES]; /* early accepted packets of current reception */
+	uint8_t passes;
+	uint8_t recent[TFA_CANDIDATES][TFA_BUF_BYTES]; /* last elected packets (duplicates of other inputs are merged) */
+	uint8_t recents;
+	uint16_t recent_time; /* time of last passed packet [s] */
 	uint8_t packet[TFA_BUF_BYTES];
+	uint8_t quality; /* link quality of packet [%] */
 	uint8_t flags;
 }TTFA;
 
+// low-pulse width histogram (for tuning of TFA_T_* decision rules)
+#define TFA_HIST_BINS 256 /* histogram bins, one per tick of 8-bit pulse timer (last bin is overflow) */
+
+// early accept (reading published before end of transmission)
+#define TFA_EARLY_MIN 2 /* min identical consecutive repetitions for early accept */
+
+// raw edge streaming (coding see tfa_core.h)
+#define TFA_RAW_BUF 64 /* raw edge stream ring buffer size (power of 2, max 128) */
+
 #define SENSOR_CHANNELS 3 /* recognized sensor channels */
 
 // decoded sensor data
@@ -64,17 +164,29 @@ typedef struct{
 typedef struct{
 	uint8_t id;
 	uint8_t channel;
-	float temp;
+	int16_t temp; /* temperature [0.1 degC] */
 	uint8_t rh;	
 	uint8_t type;
+	uint8_t quality; /* link quality [%] */
 	uint8_t flags;
+	int16_t dew; /* dew point [0.1 degC] (see derive.c) */
+	uint16_t ah; /* absolute humidity [0.01 g/m3] */
+	int16_t hi; /* heat index [0.1 degC] */
 }TSensor;
 
 
 // --- functions:
 void tfa_init(TTFA *tfa);
 uint8_t tfa_proc_packets(TTFA *tfa);
-uint8_t tfa_parse(TTFA *tfa, TSensor *sensor);
+void tfa_hist_clear(void);
+uint16_t tfa_hist_get(uint8_t bin);
+void tfa_raw_mode(TTFA *tfa, uint8_t enable);
+uint8_t tfa_raw_pop(uint8_t *byte);
+uint16_t tfa_raw_get_lost(void);
+void tfa_early_mode(TTFA *tfa, uint8_t reps, uint8_t suppress);
+uint8_t tfa_early_get(void);
+uint16_t tfa_time(void);
+void tfa_listen(uint8_t enable);
 
 
 
@@ -0,0 +1,163 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// This module contains hardware independent parts of the decoder, so the
+// same code runs on the AVR receiver and in the host tools (see ../../host).
+//
+// Packet assembler tfa_rx_pulse() (see tfa_core.h) is fed by low-pulse
+// widths in ticks. At the end of transmission the received repetitions are
+// passed to tfa_elect() to select the most common packet data (of up to
+// two overlapping sensors) which is finally decoded by tfa_parse().
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tfa.h"
+#include "tfa_core.h"
+
+// elect packets with most repetitions from received packets, returns count of elected packets (0 to TFA_CANDIDATES)
+// note: received packets may come from overlapping transmissions of more sensors, so they are clustered by content
+//       and each elected packet must be the unique most common packet of its sensor (rest are corrupted copies)
+uint8_t tfa_elect(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, uint8_t cand[][TFA_BUF_BYTES])
+{
+	// count repetitions of each unique packet (duplicates are marked -1)
+	int8_t counts[TFA_POOL];
+	memset((void*)counts,0,TFA_POOL);
+	for(uint8_t m = 0;m < packets;m++)
+	{
+		if(counts[m] < 0)
+			continue;
+		for(uint8_t n = m;n < packets;n++)
+		{
+			if(!memcmp((void*)&buf[m][0],(void*)&buf[n][0],TFA_BUF_BYTES))
+			{
+				counts[m]++;
+				if(n != m)
+					counts[n] = -1;
+			}
+		}
+	}
+
+	// elect most common packets of different sensors
+	uint8_t cands = 0;
+	while(cands < TFA_CANDIDATES)
+	{
+		int8_t maxv = 0;
+		uint8_t maxid = 0;
+		for(uint8_t m = 0;m < packets;m++)
+		{
+			if(counts[m] > maxv)
+			{
+				maxv = counts[m];
+				maxid = m;
+			}
+		}
+		if(maxv < TFA_MIN_REPS)
+			break;
+
+		// drop other packets of the same sensor, cannot decide if some of them is as common
+		uint8_t tie = 0;
+		for(uint8_t m = 0;m < packets;m++)
+		{
+			if(m != maxid && counts[m] > 0 && TFA_SAME_SENSOR(buf[m],buf[maxid]))
+			{
+				if(counts[m] == maxv)
+					tie = 1;
+				counts[m] = 0;
+			}
+		}
+		counts[maxid] = 0;
+		if(!tie)
+			memcpy((void*)&cand[cands++][0],(void*)&buf[maxid][0],TFA_BUF_BYTES);
+	}
+	return(cands);
+}
+
+// integer square root
+static uint16_t tfa_isqrt(uint32_t x)
+{
+	uint32_t root = 0;
+	for(uint32_t bit = 1ul<<30;bit;bit >>= 2)
+	{
+		if(x >= root + bit)
+		{
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+	}
+	return((uint16_t)root);
+}
+
+// link quality score [%] of reception: identical repetitions received of expected, repetitions disagreeing with them,
+// glitches during transmission and std. deviation of gap widths within bit classes (weights TFA_Q_*)
+uint8_t tfa_quality(uint8_t reps, uint8_t expected, uint8_t disagree, const TTFAStat *stat)
+{
+	if(reps > expected)
+		reps = expected;
+	if(disagree > expected - reps)
+		disagree = expected - reps; // pooled inputs: only missing repetitions may disagree
+	int16_t q = 100*reps/expected;
+	q -= TFA_Q_DISAGREE*disagree;
+	q -= TFA_Q_GLITCH*stat->glitches;
+
+	// gap width variance [ticks^2/64] of both classes around their means
+	uint32_t ss = 0;
+	uint16_t n = 0;
+	for(uint8_t c = 0;c < 2;c++)
+	{
+		if(!stat->n[c])
+			continue;
+		ss += stat->sum2[c] - (uint32_t)stat->sum[c]*stat->sum[c]/stat->n[c];
+		n += stat->n[c];
+	}
+	if(n)
+	{
+		// penalty is clamped, so inconsistent statistics (noise) cannot wrap it
+		uint32_t jitter = (uint32_t)tfa_isqrt(64*ss/n)*TFA_TICK_US/(8*TFA_Q_JITTER_US);
+		q -= (jitter > 100)?100:(int16_t)jitter;
+	}
+
+	if(q < 0)
+		q = 0;
+	return((uint8_t)q);
+}
+
+// link quality score [%] of elected packet from received packets (expected TFA_PACKETS repetitions, disagreeing are other packets of the same sensor)
+uint8_t tfa_link_quality(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, const uint8_t *packet, const TTFAStat *stat)
+{
+	uint8_t reps = 0;
+	uint8_t disagree = 0;
+	for(uint8_t m = 0;m < packets;m++)
+	{
+		if(!memcmp((void*)&buf[m][0],(void*)packet,TFA_BUF_BYTES))
+			reps++;
+		else if(TFA_SAME_SENSOR(buf[m],packet))
+			disagree++;
+	}
+	return(tfa_quality(reps,TFA_PACKETS,disagree,stat));
+}
+
+// parse packet data to sensor struct
+uint8_t tfa_parse(TTFA *tfa, TSensor *sensor)
+{
+	const uint8_t *pkt = tfa->packet;
+	sensor->rh = TFA_FIELD(pkt,TFA_F_RH);
+	// sign extend 12-bit temperature
+	sensor->temp = (int16_t)(TFA_FIELD(pkt,TFA_F_TEMP) ^ 0x0800u) - 0x0800;
+	sensor->channel = 1 + TFA_FIELD(pkt,TFA_F_CHANNEL);
+	sensor->id = TFA_FIELD(pkt,TFA_F_ID);
+	sensor->type = TFA_FIELD(pkt,TFA_F_TYPE);
+	sensor->quality = tfa->quality;
+	sensor->flags = TFA_NEW_PACKET | (TFA_FIELD(pkt,TFA_F_FLAGS) & (TFA_LOW_BATT | TFA_SYNC));
+	return(sensor->type == TFA_TYPE);
+}
+
@@ -0,0 +1,166 @@
+//-----------------------------------------------------------------------------
+// Part of simple interface for radio sensors TFA Dostmann 30.3215.02.
+// Hardware independent decoder core shared by AVR receiver and host tools.
+// See tfa_core.c and tfa.c for more details.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef TFA_CORE_H_
+#define TFA_CORE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tfa.h"
+
+// packet assembler state (fed by low-pulse widths)
+typedef struct{
+	uint8_t buf[TFA_SLOTS][TFA_BUF_BYTES]; /* received packets */
+	int8_t bit; /* remaining bits of current packet (negative if invalid) */
+	uint8_t packet; /* received packets count */
+	uint8_t early; /* identical consecutive repetitions for early accept (0 = disabled) */
+	uint8_t reps; /* identical consecutive repetitions of last packet */
+	uint8_t listen; /* listen window: relaxed glitch rejection (weak sensor expected) */
+	uint8_t burst; /* transmission in progress (start bit received since last gap) */
+	TTFAStat stat; /* statistics of transmission (valid until next start bit after gap) */
+	TTFAStat pkt; /* gap statistics of packet being received (added to stat when it is complete) */
+}TTFARx;
+
+// every complete packet of first TFA_PACKETS is counted once, so the statistics cannot wrap
+#if TFA_PACKETS*TFA_BITS > 255
+	#error "TFA_PACKETS*TFA_BITS gaps do not fit 8-bit counters of TTFAStat."
+#endif
+
+// tfa_rx_pulse() result flag: last received packet is early accepted (bits 6..0 = received packets count)
+#define TFA_RX_EARLY (1<<7)
+
+// raw edge stream coding (TFA:RAW mode), one varint symbol per edge:
+//   byte 0: bit 7 = next byte follows, bit 6 = ended level (1=high, 0=low), bits 5..0 = duration bits 5..0
+//   byte 1: bits 1..0 = duration bits 7..6 (only if duration >= 64 ticks)
+//   symbol 0xFF,0x7F marks lost edges (receiver ring overflow), decoder must restart packet
+#define TFA_RAW_MORE (1<<7) /* symbol continues by next byte */
+#define TFA_RAW_HIGH (1<<6) /* duration of high level (pulse), otherwise low level (gap) */
+#define TFA_RAW_MASK 0x3Fu /* duration bits in first byte */
+#define TFA_RAW_LOST 0x7Fu /* second byte value of lost edges marker */
+
+// packets come from the same sensor (id, channel and type match)?
+#define TFA_SAME_SENSOR(a,b) ((a)[3] == (b)[3] && (a)[4] == (b)[4] && (((a)[2] ^ (b)[2]) & 0x30u) == 0)
+
+
+// reset packet assembler (no packet in progress, so stop pulse before the first start bit is not a packet)
+static inline void tfa_rx_init(TTFARx *rx)
+{
+	memset((void*)rx,0,sizeof(TTFARx));
+	rx->bit = -1;
+}
+
+// process single low-pulse width [ticks], returns received packets count at the end of transmission,
+// TFA_RX_EARLY|count when last packet reached early accept repetitions, 0 otherwise
+// note: inlined as it runs in the tick ISR
+static inline uint8_t tfa_rx_pulse(TTFARx *rx, uint8_t ticks)
+{
+	if(rx->listen?TFA_IS_GLITCH_LISTEN(ticks):TFA_IS_GLITCH(ticks))
+	{
+		// glitch pulse - reject
+		rx->bit = -1;
+		if(rx->burst && rx->stat.glitches < 255)
+			rx->stat.glitches++;
+	}
+	else if(TFA_IS_STOP(ticks))
+	{
+		// stop bit - packet end
+		if(rx->bit == 0)
+		{
+			// full packet received
+			rx->bit--;
+			if(rx->packet < TFA_PACKETS)
+			{
+				// complete packet: add its gap statistics to transmission
+				for(uint8_t c = 0;c < 2;c++)
+				{
+					rx->stat.n[c] += rx->pkt.n[c];
+					rx->stat.sum[c] += rx->pkt.sum[c];
+					rx->stat.sum2[c] += rx->pkt.sum2[c];
+				}
+			}
+			if(rx->packet < TFA_SLOTS)
+			{
+				// count identical consecutive repetitions (early accept)
+				if(rx->early && rx->packet && !memcmp((void*)&rx->buf[rx->packet][0],(void*)&rx->buf[rx->packet-1][0],TFA_BUF_BYTES))
+					rx->reps++;
+				else
+					rx->reps = 1;
+				rx->packet++;
+				if(rx->reps == rx->early)
+					return(TFA_RX_EARLY | rx->packet);
+			}
+		}
+	}
+	else if(TFA_IS_GAP(ticks))
+	{
+		// end of transmission: return received packets count if it makes sense
+		uint8_t packets = rx->packet;
+		// restart receiver (gap is never inside packet, so packet in progress is invalid)
+		rx->bit = -1;
+		rx->packet = 0;
+		rx->reps = 0;
+		rx->burst = 0;
+		if(packets >= TFA_MIN_REPS)
+			return(packets);
+	}
+	else if(TFA_IS_START(ticks))
+	{
+		// start bit
+		rx->bit = TFA_BITS;
+		memset((void*)&rx->pkt,0,sizeof(TTFAStat));
+		if(!rx->burst)
+		{
+			// new transmission: reset statistics
+			rx->burst = 1;
+			memset((void*)&rx->stat,0,sizeof(TTFAStat));
+		}
+		if(rx->packet < TFA_SLOTS)
+			rx->buf[rx->packet][TFA_BUF_BYTES-1] = 0x00; // clear last unfull byte of packet
+	}
+	else
+	{
+		// data bit - place to buffer
+		if(rx->bit > 0 && rx->packet < TFA_SLOTS)
+		{
+			rx->bit--;
+			uint8_t data = TFA_IS_HIGH(ticks);
+			uint8_t bit = 1<<(rx->bit&0x07u);
+			uint8_t *byte = &rx->buf[rx->packet][rx->bit>>3];
+			*byte = *byte & ~bit;
+			if(data)
+				*byte |= bit;
+			if(rx->packet < TFA_PACKETS)
+			{
+				// gap width statistics of bit class (of packet until it is complete, restarted packet is not counted twice)
+				rx->pkt.n[data]++;
+				rx->pkt.sum[data] += ticks;
+				rx->pkt.sum2[data] += (uint16_t)ticks*ticks;
+			}
+		}
+		else if(rx->bit >= 0)
+			rx->bit--;
+	}
+	return(0);
+}
+
+
+// --- functions:
+uint8_t tfa_elect(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, uint8_t cand[][TFA_BUF_BYTES]);
+uint8_t tfa_quality(uint8_t reps, uint8_t expected, uint8_t disagree, const TTFAStat *stat);
+uint8_t tfa_link_quality(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, const uint8_t *packet, const TTFAStat *stat);
+uint8_t tfa_parse(TTFA *tfa, TSensor *sensor);
+
+
+
+#endif
@@ -0,0 +1,118 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Edge decoder: feeds low-pulse widths in receiver ticks to the very same
+// decoder core as used by the AVR receiver (../AVR/avr-tfa-rx-test/tfa_core.c)
+// and reports decoded sensors via callback.
+//
+// Besides the receiver's election of the most common packet it supports
+// bitwise majority of repetitions (DEC_MAJORITY mode) for comparison.
+// Source of the widths can be raw edge stream sent by receiver in TFA:RAW
+// mode (dec_raw()) or any other edge detector (dec_low()).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+
+// initialize edge decoder
+void dec_init(TDec *dec, TDecSensorCb cb, void *user)
+{
+	memset((void*)dec,0,sizeof(TDec));
+	tfa_rx_init(&dec->rx);
+	dec->cb = cb;
+	dec->user = user;
+}
+
+// bitwise majority of received packets, returns 0 if some bit is undecided
+static uint8_t dec_majority(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, uint8_t *packet)
+{
+	for(uint8_t k = 0;k < TFA_BUF_BYTES;k++)
+	{
+		uint8_t byte = 0;
+		for(uint8_t b = 0;b < 8;b++)
+		{
+			uint8_t ones = 0;
+			for(uint8_t p = 0;p < packets;p++)
+				ones += (buf[p][k] >> b) & 1;
+			if(2*ones == packets)
+				return(0);
+			if(2*ones > packets)
+				byte |= 1<<b;
+		}
+		packet[k] = byte;
+	}
+	return(1);
+}
+
+// process single low-pulse width [ticks]
+void dec_low(TDec *dec, uint8_t ticks)
+{
+	uint8_t packets = tfa_rx_pulse(&dec->rx,ticks);
+	if(!packets)
+		return;
+	// end of transmission: elect and parse packets (tfa_proc_packets() equivalent)
+	dec->transmissions++;
+	uint8_t cand[TFA_CANDIDATES][TFA_BUF_BYTES];
+	uint8_t cands;
+	if(dec->mode == DEC_MAJORITY)
+		cands = dec_majority(dec->rx.buf,packets,cand[0]);
+	else
+		cands = tfa_elect(dec->rx.buf,packets,cand);
+	for(uint8_t k = 0;k < cands;k++)
+	{
+		memcpy((void*)dec->tfa.packet,(void*)cand[k],TFA_BUF_BYTES);
+		dec->tfa.quality = tfa_link_quality(dec->rx.buf,packets,cand[k],&dec->rx.stat);
+		TSensor sensor;
+		if(!tfa_parse(&dec->tfa,&sensor))
+			continue;
+		dec->packets++;
+		if(dec->cb)
+			dec->cb(&sensor,dec->user);
+	}
+}
+
+// process raw edge stream data (TFA:RAW mode of receiver)
+void dec_raw(TDec *dec, const uint8_t *data, size_t size)
+{
+	while(size--)
+	{
+		uint8_t code = *data++;
+		uint8_t ticks;
+		if(dec->raw_code)
+		{
+			// second byte of symbol
+			uint8_t first = dec->raw_code;
+			dec->raw_code = 0;
+			if(code == TFA_RAW_LOST)
+			{
+				// lost edges: act as glitch to restart packet
+				dec->lost++;
+				dec_low(dec,0);
+				continue;
+			}
+			ticks = (first & TFA_RAW_MASK) | (code << 6);
+			code = first;
+		}
+		else if(code & TFA_RAW_MORE)
+		{
+			// first byte of long symbol
+			dec->raw_code = code;
+			continue;
+		}
+		else
+			ticks = code & TFA_RAW_MASK;
+
+		// only low levels carry data
+		if(!(code & TFA_RAW_HIGH))
+			dec_low(dec,ticks);
+	}
+}
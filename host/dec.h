@@ -0,0 +1,45 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Edge decoder built on the AVR receiver decoder core, see dec.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef DEC_H_
+#define DEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tfa_core.h"
+
+// packet election modes
+#define DEC_ELECT 0 /* most common packet (tfa_elect(), as receiver) */
+#define DEC_MAJORITY 1 /* bitwise majority of repetitions */
+
+// decoded sensor callback
+typedef void (*TDecSensorCb)(const TSensor *sensor, void *user);
+
+typedef struct{
+	TTFARx rx; /* packet assembler (same as AVR tick ISR) */
+	TTFA tfa; /* elected packet */
+	uint8_t mode; /* packet election mode */
+	uint8_t raw_code; /* pending first byte of raw stream symbol */
+	TDecSensorCb cb; /* decoded sensor callback */
+	void *user; /* callback user data */
+	uint32_t transmissions; /* received transmissions */
+	uint32_t packets; /* decoded sensor packets */
+	uint32_t lost; /* raw stream lost edges markers */
+}TDec;
+
+// --- functions:
+void dec_init(TDec *dec, TDecSensorCb cb, void *user);
+void dec_low(TDec *dec, uint8_t ticks);
+void dec_raw(TDec *dec, const uint8_t *data, size_t size);
+
+#endif
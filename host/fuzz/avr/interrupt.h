@@ -0,0 +1,21 @@
+//-----------------------------------------------------------------------------
+// Part of fuzzing harnesses for radio sensors TFA Dostmann 30.3215.02.
+// Host shim of avr-libc <avr/interrupt.h>: ISR is plain function called by
+// harness (no concurrency with main loop code).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FUZZ_AVR_INTERRUPT_H_
+#define FUZZ_AVR_INTERRUPT_H_
+
+#define ISR(vector) void vector(void); void vector(void)
+#define sei()
+#define cli()
+
+#endif
@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------
+// Part of fuzzing harnesses for radio sensors TFA Dostmann 30.3215.02.
+// Host shim of avr-libc <avr/io.h>: registers used by serial.c are plain
+// bytes of fuzz_sfr[], harness feeds UDR0 and keeps UCSR0A flags set.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FUZZ_AVR_IO_H_
+#define FUZZ_AVR_IO_H_
+
+#include <stdint.h>
+
+// MCU traits of hal.h
+#define __AVR_ATmega644__ 1
+
+extern volatile uint8_t fuzz_sfr[64];
+#define _SFR(x) (fuzz_sfr[x])
+#define _SFR16(x) (*(volatile uint16_t*)&fuzz_sfr[x])
+
+// ports
+#define PORTB _SFR(0)
+#define DDRB _SFR(1)
+#define PINB _SFR(2)
+#define PORTD _SFR(3)
+#define DDRD _SFR(4)
+#define PIND _SFR(5)
+#define PB0 0
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+// timer 1, pin change IRQ (auto-baud)
+#define TCCR1A _SFR(8)
+#define TCCR1B _SFR(9)
+#define TCNT1 _SFR16(10)
+#define CS10 0
+#define PCICR _SFR(12)
+#define PCMSK3 _SFR(13)
+#define PCIE3 3
+#define PCINT24 0
+
+// USART 0
+#define UCSR0A _SFR(16)
+#define UCSR0B _SFR(17)
+#define UCSR0C _SFR(18)
+#define UBRR0 _SFR16(20)
+#define UDR0 _SFR(22)
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define U2X0 1
+#define RXCIE0 7
+#define RXEN0 4
+#define TXEN0 3
+#define UMSEL00 6
+#define UPM00 4
+#define USBS0 3
+#define UCSZ00 1
+
+#define _BV(bit) (1<<(bit))
+#define bit_is_set(sfr,bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr,bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr,bit) do{}while(bit_is_clear(sfr,bit))
+#define loop_until_bit_is_clear(sfr,bit) do{}while(bit_is_set(sfr,bit))
+
+// avr-libc extension of <stdlib.h>
+char *itoa(int val, char *s, int radix);
+
+#endif
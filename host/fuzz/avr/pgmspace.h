@@ -0,0 +1,28 @@
+//-----------------------------------------------------------------------------
+// Part of fuzzing harnesses for radio sensors TFA Dostmann 30.3215.02.
+// Host shim of avr-libc <avr/pgmspace.h>: flash is plain memory.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FUZZ_AVR_PGMSPACE_H_
+#define FUZZ_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define strcmp_P strcmp
+#define sprintf_P sprintf
+
+#endif
@@ -0,0 +1,271 @@
+//-----------------------------------------------------------------------------
+// Standalone driver of fuzzing harnesses for toolchains without libFuzzer
+// (gcc). Links with harness providing LLVMFuzzerTestOneInput() and runs it
+// under ASan/UBSan (see Makefile).
+//
+// Usage:
+//   fuzz_xxx [-r runs] [-m max_len] [-S seed] [-t timeout] [file|dir ...]
+//     file|dir - inputs (corpus, crash reproducers) run once each, all
+//                files of directory
+//     -r - random runs: inputs mutated from the given ones (bit flips,
+//          byte changes, inserts, deletes, chunk copies) or random bytes
+//     -m - max length of random inputs (default 1024)
+//     -S - random seed (default 1)
+//     -t - timeout per input [s] (default 5), catches infinite loops
+//   Input which crashed, failed a check or timed out is written to
+//   crash-<run> file in current folder.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sanitizer/common_interface_defs.h>
+
+#define DRIVER_CORPUS 1024 /* max corpus inputs */
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// UBSan reports end by abort(), so the input is saved as for other failures
+const char *__ubsan_default_options(void)
+{
+	return("print_stacktrace=1:abort_on_error=1");
+}
+
+// corpus
+static uint8_t *corpus[DRIVER_CORPUS];
+static size_t corpus_size[DRIVER_CORPUS];
+static unsigned corpus_count = 0;
+
+// current input (saved on failure)
+static uint8_t *cur_data;
+static size_t cur_size;
+static unsigned long cur_run;
+
+static uint64_t rng_state;
+static uint64_t rng(void)
+{
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return(rng_state*2685821657736338717ull);
+}
+
+// write current input to crash file (async signal safe)
+static void driver_save(void)
+{
+	char name[32] = "crash-";
+	char num[20];
+	int n = 0;
+	unsigned long v = cur_run;
+	do{num[n++] = '0' + v%10; v /= 10;}while(v);
+	int len = 6;
+	while(n)
+		name[len++] = num[--n];
+	name[len] = '\0';
+	int fd = open(name,O_WRONLY|O_CREAT|O_TRUNC,0644);
+	if(fd >= 0)
+	{
+		if(write(fd,cur_data,cur_size) < 0){}
+		close(fd);
+	}
+	static const char msg[] = "input saved to crash file\n";
+	if(write(2,msg,sizeof(msg) - 1) < 0){}
+}
+
+static void driver_signal(int sig)
+{
+	if(sig == SIGALRM)
+	{
+		static const char msg[] = "timeout (infinite loop?)\n";
+		if(write(2,msg,sizeof(msg) - 1) < 0){}
+	}
+	driver_save();
+	signal(SIGABRT,SIG_DFL);
+	abort();
+}
+
+// run single input
+static void driver_run(uint8_t *data, size_t size, unsigned timeout)
+{
+	cur_data = data;
+	cur_size = size;
+	alarm(timeout);
+	LLVMFuzzerTestOneInput(data,size);
+	alarm(0);
+	cur_run++;
+}
+
+// load input file to corpus
+static int driver_load(const char *path)
+{
+	FILE *fr = fopen(path,"rb");
+	if(!fr)
+	{
+		fprintf(stderr,"cannot open '%s'\n",path);
+		return(1);
+	}
+	fseek(fr,0,SEEK_END);
+	long size = ftell(fr);
+	fseek(fr,0,SEEK_SET);
+	uint8_t *data = (uint8_t*)malloc(size + 1);
+	if(!data || fread((void*)data,1,size,fr) != (size_t)size)
+	{
+		fprintf(stderr,"cannot read '%s'\n",path);
+		fclose(fr);
+		free(data);
+		return(1);
+	}
+	fclose(fr);
+	if(corpus_count < DRIVER_CORPUS)
+	{
+		corpus[corpus_count] = data;
+		corpus_size[corpus_count++] = size;
+	}
+	else
+		free(data);
+	return(0);
+}
+
+// load file or all files of directory
+static int driver_path(const char *path)
+{
+	struct stat st;
+	if(stat(path,&st) || !S_ISDIR(st.st_mode))
+		return(driver_load(path));
+	DIR *dir = opendir(path);
+	if(!dir)
+		return(1);
+	struct dirent *ent;
+	char name[1024];
+	while((ent = readdir(dir)))
+	{
+		if(ent->d_name[0] == '.')
+			continue;
+		snprintf(name,sizeof(name),"%s/%s",path,ent->d_name);
+		if(driver_load(name))
+			return(1);
+	}
+	closedir(dir);
+	return(0);
+}
+
+// make random input into buf, returns its size
+static size_t driver_mutate(uint8_t *buf, size_t max)
+{
+	size_t size;
+	if(!corpus_count || !(rng()%8))
+	{
+		// random bytes
+		size = rng()%(max + 1);
+		for(size_t k = 0;k < size;k++)
+			buf[k] = rng();
+		return(size);
+	}
+	unsigned id = rng()%corpus_count;
+	size = (corpus_size[id] > max) ? max : corpus_size[id];
+	memcpy((void*)buf,(void*)corpus[id],size);
+	unsigned muts = 1 + rng()%8;
+	for(unsigned m = 0;m < muts;m++)
+	{
+		size_t pos = size ? rng()%size : 0;
+		switch(rng()%5)
+		{
+			case 0: // bit flip
+				if(size)
+					buf[pos] ^= 1<<(rng()%8);
+				break;
+			case 1: // random byte
+				if(size)
+					buf[pos] = rng();
+				break;
+			case 2: // insert byte
+				if(size < max)
+				{
+					memmove((void*)&buf[pos + 1],(void*)&buf[pos],size - pos);
+					buf[pos] = rng();
+					size++;
+				}
+				break;
+			case 3: // delete chunk
+				if(size)
+				{
+					size_t len = 1 + rng()%(size - pos);
+					memmove((void*)&buf[pos],(void*)&buf[pos + len],size - pos - len);
+					size -= len;
+				}
+				break;
+			default: // copy chunk over other place
+				if(size)
+				{
+					size_t src = rng()%size;
+					size_t len = 1 + rng()%(size - (src > pos ? src : pos));
+					memmove((void*)&buf[pos],(void*)&buf[src],len);
+				}
+				break;
+		}
+	}
+	return(size);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long runs = 0;
+	size_t max = 1024;
+	unsigned timeout = 5;
+	rng_state = 1;
+	for(int k = 1;k < argc;k++)
+	{
+		if(argv[k][0] == '-' && k + 1 < argc && strchr("rmSt",argv[k][1]) && !argv[k][2])
+		{
+			const char *val = argv[++k];
+			switch(argv[k - 1][1])
+			{
+				case 'r': runs = strtoul(val,NULL,10); break;
+				case 'm': max = strtoul(val,NULL,10); break;
+				case 'S': rng_state = strtoull(val,NULL,10)*0x9E3779B97F4A7C15ull + 1; break;
+				case 't': timeout = strtoul(val,NULL,10); break;
+			}
+		}
+		else if(argv[k][0] == '-')
+		{
+			fprintf(stderr,"usage: %s [-r runs] [-m max_len] [-S seed] [-t timeout] [file|dir ...]\n",argv[0]);
+			return(1);
+		}
+		else if(driver_path(argv[k]))
+			return(1);
+	}
+
+	signal(SIGALRM,driver_signal);
+	signal(SIGABRT,driver_signal);
+	signal(SIGSEGV,driver_signal);
+	__sanitizer_set_death_callback(driver_save);
+
+	// given inputs
+	for(unsigned k = 0;k < corpus_count;k++)
+		driver_run(corpus[k],corpus_size[k],timeout);
+
+	// random inputs
+	uint8_t *buf = (uint8_t*)malloc(max + 1);
+	for(unsigned long k = 0;k < runs;k++)
+	{
+		size_t size = driver_mutate(buf,max);
+		driver_run(buf,size,timeout);
+	}
+	fprintf(stderr,"%s: %lu inputs OK\n",argv[0],cur_run);
+	free(buf);
+	return(0);
+}
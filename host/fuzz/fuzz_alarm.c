@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+// Fuzzing harness of threshold alarms (alarm.c) of TFA Dostmann 30.3215.02
+// receiver and their output pin handling done by TFA:ALARM commands and
+// reading processing in main.c.
+//
+// Input is sequence of operations, channel is (op >> 2) % SENSOR_CHANNELS:
+//   op % 3 == 0 - TFA:ALARM, 7 bytes follow: t_low [0.5 degC, int8],
+//                 t_high - t_low - 1 [0.2 degC], rh_low, rh_high - rh_low,
+//                 t_hyst, rh_hyst, debounce - 1 (all modulo valid ranges)
+//   op % 3 == 1 - TFA:ALARM:OFF
+//   op % 3 == 2 - reading, 2 bytes follow: temperature [degC, int8], rh
+// Checked after every operation: alarm pin is high exactly while any alarm
+// is active (e.g. re-armed tripped alarm must release the pin), state of
+// disabled alarm is clear, ASan/UBSan.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include "main.h"
+#include "alarm.h"
+
+#define FUZZ_CHECK(cond) if(!(cond)){fprintf(stderr,"check failed: %s (%s:%d)\n",#cond,__FILE__,__LINE__);abort();}
+
+volatile uint8_t fuzz_sfr[64];
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	TAlarm alarms[SENSOR_CHANNELS];
+	for(uint8_t k = 0;k < SENSOR_CHANNELS;k++)
+		alarm_init(&alarms[k]);
+	memset((void*)fuzz_sfr,0,sizeof(fuzz_sfr));
+	sbi(ALARM_DDR,ALARM);
+
+	while(size)
+	{
+		uint8_t op = *data++;
+		size--;
+		TAlarm *alm = &alarms[(op >> 2) % SENSOR_CHANNELS];
+		if(op % 3 == 0)
+		{
+			// TFA:ALARM
+			if(size < 7)
+				break;
+			int16_t t_low = 5*(int8_t)data[0];
+			int16_t t_high = t_low + 1 + 2*data[1];
+			uint8_t rh_low = data[2] % 100;
+			uint8_t rh_high = rh_low + 1 + data[3] % (100 - rh_low);
+			alarm_setup(alm,t_low,t_high,rh_low,rh_high,data[4],data[5] % 101,1 + data[6] % ALM_DEBOUNCE_MAX);
+			alarm_output(alarms,SENSOR_CHANNELS);
+			FUZZ_CHECK(!alm->state);
+			data += 7;
+			size -= 7;
+		}
+		else if(op % 3 == 1)
+		{
+			// TFA:ALARM:OFF
+			alarm_init(alm);
+			alarm_output(alarms,SENSOR_CHANNELS);
+			FUZZ_CHECK(!alm->state);
+		}
+		else
+		{
+			// reading of channel sensor
+			if(size < 2)
+				break;
+			TSensor sensor;
+			memset((void*)&sensor,0,sizeof(sensor));
+			sensor.temp = 10*(int8_t)data[0];
+			sensor.rh = data[1] % 101;
+			if(alarm_check(alm,&sensor))
+				alarm_output(alarms,SENSOR_CHANNELS);
+			FUZZ_CHECK((alm->flags & ALM_ON) || !alm->state);
+			data += 2;
+			size -= 2;
+		}
+		FUZZ_CHECK(!!(ALARM_PORT & (1<<ALARM)) == !!alarm_active(alarms,SENSOR_CHANNELS));
+	}
+	return(0);
+}
@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+// Fuzzing harness of packet election and link quality (tfa_core.c) of
+// TFA Dostmann 30.3215.02 receiver. Built for the largest pool (4 inputs
+// of antenna diversity, TFA_POOL packets).
+//
+// Input: packets count byte, TTFAStat bytes (any statistics), then packets,
+// each is either byte with bit 7 set - copy of earlier packet (index in
+// bits 6..0, modulo count) or byte without it followed by TFA_BUF_BYTES new bytes, so
+// repetitions are easy to reach. Checked: candidates are packets repeated
+// at least TFA_MIN_REPS times, of different sensors and not less common
+// than other packets of their sensor, quality in range, ASan/UBSan.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tfa_core.h"
+
+#define FUZZ_CHECK(cond) if(!(cond)){fprintf(stderr,"check failed: %s (%s:%d)\n",#cond,__FILE__,__LINE__);abort();}
+
+// count of packets identical to packet
+static uint8_t fuzz_count(uint8_t buf[][TFA_BUF_BYTES], uint8_t packets, const uint8_t *packet)
+{
+	uint8_t count = 0;
+	for(uint8_t m = 0;m < packets;m++)
+		count += !memcmp((void*)buf[m],(void*)packet,TFA_BUF_BYTES);
+	return(count);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if(size < 1 + sizeof(TTFAStat))
+		return(0);
+	uint8_t packets = data[0] % (TFA_POOL + 1);
+	TTFAStat stat;
+	memcpy((void*)&stat,(void*)&data[1],sizeof(TTFAStat));
+	data += 1 + sizeof(TTFAStat);
+	size -= 1 + sizeof(TTFAStat);
+
+	uint8_t buf[TFA_POOL][TFA_BUF_BYTES];
+	uint8_t count;
+	for(count = 0;count < packets && size;count++)
+	{
+		uint8_t code = *data++;
+		size--;
+		if((code & 0x80u) && count)
+			memcpy((void*)buf[count],(void*)buf[(code & 0x7Fu) % count],TFA_BUF_BYTES);
+		else if(size >= TFA_BUF_BYTES)
+		{
+			memcpy((void*)buf[count],(void*)data,TFA_BUF_BYTES);
+			data += TFA_BUF_BYTES;
+			size -= TFA_BUF_BYTES;
+		}
+		else
+			break;
+	}
+	packets = count;
+
+	uint8_t cand[TFA_CANDIDATES][TFA_BUF_BYTES];
+	uint8_t cands = tfa_elect(buf,packets,cand);
+	FUZZ_CHECK(cands <= TFA_CANDIDATES);
+	for(uint8_t k = 0;k < cands;k++)
+	{
+		uint8_t reps = fuzz_count(buf,packets,cand[k]);
+		FUZZ_CHECK(reps >= TFA_MIN_REPS);
+		for(uint8_t m = 0;m < packets;m++)
+			FUZZ_CHECK(!TFA_SAME_SENSOR(buf[m],cand[k]) || fuzz_count(buf,packets,buf[m]) < reps || !memcmp((void*)buf[m],(void*)cand[k],TFA_BUF_BYTES));
+		for(uint8_t m = 0;m < k;m++)
+			FUZZ_CHECK(!TFA_SAME_SENSOR(cand[m],cand[k]));
+		uint8_t quality = tfa_link_quality(buf,packets,cand[k],&stat);
+		FUZZ_CHECK(quality <= 100);
+	}
+	return(0);
+}
@@ -0,0 +1,85 @@
+//-----------------------------------------------------------------------------
+// Fuzzing harness of packet assembler state machine of the tick ISR
+// (tfa_rx_pulse(), tfa_core.h) and of processing of its packets (election,
+// link quality, parsing) of TFA Dostmann 30.3215.02 receiver.
+//
+// First input byte sets early accept repetitions (bits 2..0, 0 = off) and
+// listen window (bit 3), the rest are low-pulse widths in ticks as the ISR
+// feeds them. Each end of transmission is processed as tfa_proc_packets()
+// does, each early accept parses the last packet. Checked: packet counts
+// in buffer range, elected candidates and quality in range, ASan/UBSan.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tfa_core.h"
+#include "derive.h"
+
+#define FUZZ_CHECK(cond) if(!(cond)){fprintf(stderr,"check failed: %s (%s:%d)\n",#cond,__FILE__,__LINE__);abort();}
+
+// parse packet with quality as receiver does
+static void fuzz_parse(const uint8_t *packet, uint8_t quality)
+{
+	TTFA tfa;
+	memcpy((void*)tfa.packet,(void*)packet,TFA_BUF_BYTES);
+	tfa.quality = quality;
+	TSensor sensor;
+	if(tfa_parse(&tfa,&sensor))
+	{
+		FUZZ_CHECK(sensor.channel >= 1 && sensor.channel <= 4 && sensor.id < 16);
+		derive(&sensor);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if(!size)
+		return(0);
+	TTFARx rx;
+	tfa_rx_init(&rx);
+	rx.early = data[0] & 0x07u;
+	rx.listen = !!(data[0] & 0x08u);
+
+	for(size_t k = 1;k < size;k++)
+	{
+		uint8_t res = tfa_rx_pulse(&rx,data[k]);
+		FUZZ_CHECK(rx.packet <= TFA_SLOTS && rx.bit <= TFA_BITS);
+		// each gap of complete packets is counted once (no wrapped statistics)
+		FUZZ_CHECK(rx.stat.n[0] + rx.stat.n[1] <= TFA_PACKETS*TFA_BITS);
+		FUZZ_CHECK(rx.stat.sum[0] <= 255u*rx.stat.n[0] && rx.stat.sum[1] <= 255u*rx.stat.n[1]);
+		FUZZ_CHECK(rx.stat.n[0] + rx.stat.n[1] == TFA_BITS*(rx.packet < TFA_PACKETS ? rx.packet : TFA_PACKETS) || !rx.burst);
+		if(!res)
+			continue;
+		uint8_t packets = res & ~TFA_RX_EARLY;
+		FUZZ_CHECK(packets >= 1 && packets <= TFA_SLOTS);
+		if(res & TFA_RX_EARLY)
+		{
+			// early accept of last packet
+			FUZZ_CHECK(rx.early && packets == rx.packet);
+			fuzz_parse(rx.buf[packets - 1],tfa_quality(rx.early,TFA_PACKETS,0,&rx.stat));
+			continue;
+		}
+		// end of transmission
+		FUZZ_CHECK(packets >= TFA_MIN_REPS && !rx.packet);
+		uint8_t cand[TFA_CANDIDATES][TFA_BUF_BYTES];
+		uint8_t cands = tfa_elect(rx.buf,packets,cand);
+		FUZZ_CHECK(cands <= TFA_CANDIDATES);
+		for(uint8_t m = 0;m < cands;m++)
+		{
+			uint8_t quality = tfa_link_quality(rx.buf,packets,cand[m],&rx.stat);
+			FUZZ_CHECK(quality <= 100);
+			fuzz_parse(cand[m],quality);
+		}
+	}
+	return(0);
+}
@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// Fuzzing harness of UART receiver ISR and SCPI tokeniser (serial.c) of
+// TFA Dostmann 30.3215.02 receiver. Firmware source is built unchanged
+// with host shims of avr-libc headers (avr/, util/).
+//
+// Input bytes are received by the USART ISR one by one, except control
+// bytes which run main loop step instead:
+//   0x00 - serial_decode(), serial_release() of returned command
+//   0x01 - the same, then send oldest error (SYST:ERR? handler)
+// At the end the main loop is run until no command is pending. Checked:
+//   - command and parameter are NUL terminated strings inside the buffer,
+//     without terminators, command without spaces, at most RX_CMD_MAX-1
+//   - every complete command is consumed (no stuck command counter)
+//   - ASan/UBSan checks of the ring buffer pointer arithmetic
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include "serial.h"
+
+#define FUZZ_STEP 0x00 /* control byte: main loop step */
+#define FUZZ_STEP_ERR 0x01 /* control byte: main loop step and error readout */
+
+// receiver state (serial.c)
+extern char rxd[RX_BUF_SZ + RX_CMD_MAX];
+extern volatile uint8_t rxd_stat;
+extern char rxd_term;
+extern uint8_t err_read;
+extern uint8_t err_count;
+void USART0_RX_vect(void);
+
+volatile uint8_t fuzz_sfr[64];
+
+char *itoa(int val, char *s, int radix)
+{
+	(void)radix;
+	sprintf(s,"%d",val);
+	return(s);
+}
+
+#define FUZZ_CHECK(cond) if(!(cond)){fprintf(stderr,"check failed: %s (%s:%d)\n",#cond,__FILE__,__LINE__);abort();}
+
+// check string is inside receive buffer, returns its length
+static size_t fuzz_string(const char *str)
+{
+	FUZZ_CHECK(str >= rxd && str < rxd + sizeof(rxd));
+	const char *end = memchr(str,'\0',rxd + sizeof(rxd) - str);
+	FUZZ_CHECK(end);
+	size_t len = end - str;
+	FUZZ_CHECK(len < RX_CMD_MAX);
+	FUZZ_CHECK(!memchr(str,';',len) && !memchr(str,'\n',len) && !memchr(str,'\r',len));
+	return(len);
+}
+
+// main loop step, returns 1 if command was processed
+static uint8_t fuzz_step(uint8_t err)
+{
+	char *cmd;
+	char *par;
+	uint8_t res = serial_decode(&cmd,&par);
+	if(res)
+	{
+		size_t len = fuzz_string(cmd);
+		FUZZ_CHECK(!memchr(cmd,' ',len));
+		if(par)
+		{
+			FUZZ_CHECK(par > cmd + len);
+			FUZZ_CHECK(*par && *par != ' ');
+			FUZZ_CHECK(par + fuzz_string(par) < cmd + RX_CMD_MAX);
+		}
+		serial_release();
+	}
+	if(err)
+		serial_error(SCPI_ERR_noError,NULL,SCPI_ERR_SEND);
+	FUZZ_CHECK(err_count <= SCPI_ERR_QUEUE && err_read < SCPI_ERR_QUEUE);
+	return(res);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	// fresh receiver (serial_init() resets positions and flags)
+	memset((void*)rxd,0,sizeof(rxd));
+	rxd_term = '\0';
+	err_read = 0;
+	err_count = 0;
+	serial_init();
+	UCSR0A = 0xFF; // TX always ready
+
+	for(size_t k = 0;k < size;k++)
+	{
+		if(data[k] == FUZZ_STEP || data[k] == FUZZ_STEP_ERR)
+			fuzz_step(data[k] == FUZZ_STEP_ERR);
+		else
+		{
+			UDR0 = data[k];
+			USART0_RX_vect();
+		}
+		FUZZ_CHECK(rxd_stat <= RX_BUF_SZ);
+	}
+
+	// process the rest: each step consumes at least one command or terminator
+	for(uint16_t k = 0;k < RX_BUF_SZ + 1 && rxd_stat;k++)
+		fuzz_step(0);
+	FUZZ_CHECK(!rxd_stat);
+	return(0);
+}
@@ -0,0 +1,20 @@
+//-----------------------------------------------------------------------------
+// Part of fuzzing harnesses for radio sensors TFA Dostmann 30.3215.02.
+// Host shim of avr-libc <util/atomic.h>: block runs once, nothing interrupts.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FUZZ_UTIL_ATOMIC_H_
+#define FUZZ_UTIL_ATOMIC_H_
+
+#define ATOMIC_BLOCK(type) for(int atomic_once = 1;atomic_once;atomic_once = 0)
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 0
+
+#endif
@@ -0,0 +1,19 @@
+//-----------------------------------------------------------------------------
+// Part of fuzzing harnesses for radio sensors TFA Dostmann 30.3215.02.
+// Host shim of avr-libc <util/delay.h>: no delays.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef FUZZ_UTIL_DELAY_H_
+#define FUZZ_UTIL_DELAY_H_
+
+#define _delay_ms(ms)
+#define _delay_us(us)
+
+#endif
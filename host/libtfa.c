@@ -0,0 +1,233 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// C ABI of the decoder core (shared library libtfa.so) for other languages,
+// e.g. Python wrapper in python/tfa.py. It wraps the streaming decoder
+// (stream.c) and edge decoder (dec.c), so the data are decoded by the very
+// same code as in the AVR receiver.
+//
+// Decoder instance is opaque handle made by libtfa_open(). Input is fed in
+// chunks of any size as samples (int8, int16, float32 at sample rate given
+// to libtfa_open()), low-pulse widths in receiver ticks or raw edge stream
+// of the receiver. Input buffers are only read, caller keeps ownership, so
+// they can be passed without copies. Decoded sensors are queued in the
+// instance and read in plain fixed layout structs TLibTfaSensor (no floats,
+// no packing dependence), libtfa_parse() parses single packet bytes.
+// Functions are not thread safe for the same instance.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tfa_core.h"
+#include "derive.h"
+#include "dec.h"
+#include "stream.h"
+#include "libtfa.h"
+
+_Static_assert(sizeof(TLibTfaSensor) == 16,"TLibTfaSensor layout is part of ABI");
+_Static_assert(LIBTFA_SYNC == TFA_SYNC && LIBTFA_LOW_BATT == TFA_LOW_BATT,"flags are part of ABI");
+
+#define LIBTFA_QUEUE 16 /* initial sensor queue size */
+
+struct TLibTfa{
+	double fs; /* sample rate [Hz] (0 for edge input only) */
+	TStream st; /* streaming decoder (its edge decoder serves edge input) */
+	TLibTfaSensor *queue; /* decoded sensors */
+	size_t count;
+	size_t size;
+	int error; /* queue allocation failed */
+};
+
+// convert decoder sensor data to ABI struct, derived quantities only for known sensor type (zero otherwise)
+static void libtfa_sensor(TLibTfaSensor *dst, const TSensor *src, uint8_t known)
+{
+	TSensor sensor = *src;
+	memset((void*)dst,0,sizeof(TLibTfaSensor));
+	if(known)
+	{
+		derive(&sensor);
+		dst->dew = sensor.dew;
+		dst->ah = sensor.ah;
+		dst->hi = sensor.hi;
+	}
+	dst->temp = sensor.temp;
+	dst->id = sensor.id;
+	dst->channel = sensor.channel;
+	dst->rh = sensor.rh;
+	dst->type = sensor.type;
+	dst->quality = sensor.quality;
+	dst->flags = sensor.flags & (TFA_SYNC | TFA_LOW_BATT);
+}
+
+// decoded sensor callback: queue it
+static void libtfa_on_sensor(const TSensor *sensor, void *user)
+{
+	TLibTfa *lt = (TLibTfa*)user;
+	if(lt->count == lt->size)
+	{
+		size_t size = lt->size ? 2*lt->size : LIBTFA_QUEUE;
+		TLibTfaSensor *queue = (TLibTfaSensor*)realloc((void*)lt->queue,size*sizeof(TLibTfaSensor));
+		if(!queue)
+		{
+			lt->error = 1;
+			return;
+		}
+		lt->queue = queue;
+		lt->size = size;
+	}
+	libtfa_sensor(&lt->queue[lt->count++],sensor,1);
+}
+
+// ABI version (LIBTFA_ABI the library was built with)
+int libtfa_abi(void)
+{
+	return(LIBTFA_ABI);
+}
+
+// make decoder instance for sample rate fs [Hz] (0 if only edges are fed), returns NULL on failure
+TLibTfa *libtfa_open(double fs)
+{
+	if(!(fs >= 0.0))
+		return(NULL);
+	TLibTfa *lt = (TLibTfa*)calloc(1,sizeof(TLibTfa));
+	if(!lt)
+		return(NULL);
+	lt->fs = fs;
+	libtfa_reset(lt);
+	return(lt);
+}
+
+// free decoder instance
+void libtfa_close(TLibTfa *lt)
+{
+	if(!lt)
+		return;
+	free((void*)lt->queue);
+	free((void*)lt);
+}
+
+// reset decoder state and drop queued sensors
+void libtfa_reset(TLibTfa *lt)
+{
+	stream_init(&lt->st,(lt->fs > 0.0) ? lt->fs : 1.0,libtfa_on_sensor,(void*)lt);
+	lt->count = 0;
+	lt->error = 0;
+}
+
+// sensors decoded by last call since count before it, -1 if some could not be queued
+static int libtfa_result(TLibTfa *lt, size_t before)
+{
+	if(lt->error)
+	{
+		lt->error = 0;
+		return(-1);
+	}
+	return((int)(lt->count - before));
+}
+
+// feed low-pulse widths [ticks of TFA_TICK_US], returns count of decoded sensors or -1
+int libtfa_low(TLibTfa *lt, const uint8_t *ticks, size_t n)
+{
+	size_t before = lt->count;
+	while(n--)
+		dec_low(&lt->st.dec,*ticks++);
+	return(libtfa_result(lt,before));
+}
+
+// feed raw edge stream of receiver (TFA:RAW mode), returns count of decoded sensors or -1
+int libtfa_raw(TLibTfa *lt, const uint8_t *data, size_t size)
+{
+	size_t before = lt->count;
+	dec_raw(&lt->st.dec,data,size);
+	return(libtfa_result(lt,before));
+}
+
+// feed int8 samples, returns count of decoded sensors or -1 (also if no sample rate was set)
+int libtfa_i8(TLibTfa *lt, const int8_t *x, size_t n)
+{
+	if(lt->fs <= 0.0)
+		return(-1);
+	size_t before = lt->count;
+	stream_i8(&lt->st,x,n);
+	return(libtfa_result(lt,before));
+}
+
+// feed int16 samples with full_scale amplitude (32768 for 16-bit, 2048 for 12-bit, ...), returns count of decoded sensors or -1
+int libtfa_i16(TLibTfa *lt, const int16_t *x, size_t n, int32_t full_scale)
+{
+	if(lt->fs <= 0.0 || full_scale < 1 || full_scale > 32768)
+		return(-1);
+	size_t before = lt->count;
+	stream_i16(&lt->st,x,n,full_scale);
+	return(libtfa_result(lt,before));
+}
+
+// feed float samples with full_scale amplitude, returns count of decoded sensors or -1
+int libtfa_f32(TLibTfa *lt, const float *x, size_t n, float full_scale)
+{
+	if(lt->fs <= 0.0 || !(full_scale > 0.0f))
+		return(-1);
+	size_t before = lt->count;
+	stream_f32(&lt->st,x,n,full_scale);
+	return(libtfa_result(lt,before));
+}
+
+// end of samples: finish pending pulse, returns count of decoded sensors or -1
+int libtfa_flush(TLibTfa *lt)
+{
+	size_t before = lt->count;
+	if(lt->fs > 0.0)
+		stream_flush(&lt->st);
+	return(libtfa_result(lt,before));
+}
+
+// count of queued sensors
+size_t libtfa_pending(const TLibTfa *lt)
+{
+	return(lt->count);
+}
+
+// read (dequeue) up to max oldest sensors, returns count read
+size_t libtfa_read(TLibTfa *lt, TLibTfaSensor *sensors, size_t max)
+{
+	size_t count = (lt->count < max) ? lt->count : max;
+	if(!count)
+		return(0); // sensors may be NULL for max 0
+	memcpy((void*)sensors,(void*)lt->queue,count*sizeof(TLibTfaSensor));
+	lt->count -= count;
+	memmove((void*)lt->queue,(void*)&lt->queue[count],lt->count*sizeof(TLibTfaSensor));
+	return(count);
+}
+
+// get decoder counters (NULL pointers are skipped)
+void libtfa_counts(const TLibTfa *lt, uint32_t *transmissions, uint32_t *packets, uint32_t *lost)
+{
+	if(transmissions)
+		*transmissions = lt->st.dec.transmissions;
+	if(packets)
+		*packets = lt->st.dec.packets;
+	if(lost)
+		*lost = lt->st.dec.lost;
+}
+
+// parse single packet (TFA_BUF_BYTES bytes as received), returns 1 for known sensor type, 0 for other type, -1 for wrong size
+int libtfa_parse(const uint8_t *packet, size_t size, TLibTfaSensor *sensor)
+{
+	if(size != TFA_BUF_BYTES)
+		return(-1);
+	TTFA tfa;
+	memcpy((void*)tfa.packet,(void*)packet,TFA_BUF_BYTES);
+	tfa.quality = 0;
+	TSensor sens;
+	uint8_t ok = tfa_parse(&tfa,&sens);
+	libtfa_sensor(sensor,&sens,ok);
+	return(ok);
+}
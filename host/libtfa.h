@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// C ABI of the decoder core for other languages (libtfa.so), see libtfa.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef LIBTFA_H_
+#define LIBTFA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LIBTFA_ABI 2 /* ABI version (bumped on any change of functions or TLibTfaSensor) */
+
+// sensor flags
+#define LIBTFA_SYNC (1<<6) /* sync button pressed (TFA_SYNC) */
+#define LIBTFA_LOW_BATT (1<<7) /* low battery (TFA_LOW_BATT) */
+
+// decoded sensor data (fixed layout, 16 bytes)
+typedef struct{
+	int16_t temp; /* temperature [0.1 degC] */
+	int16_t dew; /* dew point [0.1 degC] */
+	uint16_t ah; /* absolute humidity [0.01 g/m3] */
+	int16_t hi; /* heat index [0.1 degC] */
+	uint8_t id; /* random sensor 4-bit ID */
+	uint8_t channel; /* channel 1-3 */
+	uint8_t rh; /* relative humidity [%] */
+	uint8_t type; /* sensor type */
+	uint8_t quality; /* link quality [%] */
+	uint8_t flags; /* LIBTFA_* flags */
+	uint8_t reserved[2];
+}TLibTfaSensor;
+
+typedef struct TLibTfa TLibTfa;
+
+// exported from libtfa.so (built with hidden visibility of everything else)
+#define LIBTFA_API __attribute__((visibility("default")))
+
+// --- functions:
+LIBTFA_API int libtfa_abi(void);
+LIBTFA_API TLibTfa *libtfa_open(double fs);
+LIBTFA_API void libtfa_close(TLibTfa *lt);
+LIBTFA_API void libtfa_reset(TLibTfa *lt);
+LIBTFA_API int libtfa_low(TLibTfa *lt, const uint8_t *ticks, size_t n);
+LIBTFA_API int libtfa_raw(TLibTfa *lt, const uint8_t *data, size_t size);
+LIBTFA_API int libtfa_i8(TLibTfa *lt, const int8_t *x, size_t n);
+LIBTFA_API int libtfa_i16(TLibTfa *lt, const int16_t *x, size_t n, int32_t full_scale);
+LIBTFA_API int libtfa_f32(TLibTfa *lt, const float *x, size_t n, float full_scale);
+LIBTFA_API int libtfa_flush(TLibTfa *lt);
+LIBTFA_API size_t libtfa_pending(const TLibTfa *lt);
+LIBTFA_API size_t libtfa_read(TLibTfa *lt, TLibTfaSensor *sensors, size_t max);
+LIBTFA_API void libtfa_counts(const TLibTfa *lt, uint32_t *transmissions, uint32_t *packets, uint32_t *lost);
+LIBTFA_API int libtfa_parse(const uint8_t *packet, size_t size, TLibTfaSensor *sensor);
+
+#endif
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Very basic OWON 7102V scope BIN file reader and writer (version SPBS02).
+// C version of ../octave/owon_read.m, but it keeps raw int8 samples,
+// so the decoder can slice them without conversion.
+// Part reverse engineering, part from here:
+//   http://bikealive.nl/owon-bin-file-format.html
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "owon.h"
+
+// get little endian 32-bit header item
+static uint32_t owon_u32(const uint8_t *head, size_t pos)
+{
+	return((uint32_t)head[pos] | ((uint32_t)head[pos+1]<<8) | ((uint32_t)head[pos+2]<<16) | ((uint32_t)head[pos+3]<<24));
+}
+
+// get 1-2-5 series item, id 0 is the first item after 10^decade
+static double owon_125(uint32_t id, int decade)
+{
+	static const double mant[3] = {1.0,2.0,5.0};
+	id++;
+	return(mant[id%3]*pow(10.0,decade + (int)(id/3)));
+}
+
+// read scope file, returns 0 if ok
+int owon_read(TOwon *owon, const char *path)
+{
+	memset((void*)owon,0,sizeof(TOwon));
+
+	FILE *fr = fopen(path,"rb");
+	if(!fr)
+		return(1);
+
+	// check header identifier
+	uint8_t head[OWON_HEAD_SIZE];
+	if(fread((void*)head,1,OWON_HEAD_SIZE,fr) != OWON_HEAD_SIZE || memcmp((void*)head,"SPBS02",6))
+	{
+		fclose(fr);
+		return(2);
+	}
+
+	// display length, sample count
+	uint32_t disp_len = owon_u32(head,25);
+	owon->count = owon_u32(head,29);
+
+	// time base [s/div]
+	double timebase = owon_125(owon_u32(head,37),-9);
+
+	// vertical offset, vertical range [V/div] with attenuation
+	owon->vert_ofs = (int32_t)owon_u32(head,41);
+	double vert = owon_125(owon_u32(head,45),-3)*pow(10.0,owon_u32(head,49));
+	owon->vert_scale = vert*5.0/125.0;
+
+	// sampling rate [Hz]
+	owon->fs = disp_len/timebase/15.2;
+	owon->Ts = 1.0/owon->fs;
+
+	// raw wave data
+	owon->u = (int8_t*)malloc(owon->count ? owon->count : 1);
+	if(!owon->u || fread((void*)owon->u,1,owon->count,fr) != owon->count)
+	{
+		owon_free(owon);
+		fclose(fr);
+		return(3);
+	}
+
+	fclose(fr);
+	return(0);
+}
+
+// release scope data
+void owon_free(TOwon *owon)
+{
+	free((void*)owon->u);
+	owon->u = NULL;
+	owon->count = 0;
+}
+
+// store little endian 32-bit header item
+static void owon_put_u32(uint8_t *head, size_t pos, uint32_t value)
+{
+	head[pos] = value;
+	head[pos+1] = value >> 8;
+	head[pos+2] = value >> 16;
+	head[pos+3] = value >> 24;
+}
+
+// write scope file header for count int8 samples at sampling rate fs (time base 100ms/div), returns 0 if ok
+// note: wave data (int8) are to be written after the header by caller
+int owon_write_head(FILE *fw, double fs, uint32_t count)
+{
+	// header items as stored by OWON 7102V, only used items are modified
+	uint8_t head[OWON_HEAD_SIZE];
+	memset((void*)head,0,OWON_HEAD_SIZE);
+	memcpy((void*)head,"SPBS02",6);
+	owon_put_u32(head,6,0x00FFFFFFul);
+	memcpy((void*)&head[10],"CH1",3);
+	owon_put_u32(head,13,(uint32_t)(-(int32_t)(count + 56)));
+	owon_put_u32(head,17,3);
+	owon_put_u32(head,21,120000);
+	owon_put_u32(head,25,(uint32_t)lround(fs*0.1*15.2)); // display length for 100ms/div
+	owon_put_u32(head,29,count);
+	owon_put_u32(head,37,23); // 100ms/div
+	owon_put_u32(head,41,(uint32_t)-100);
+	owon_put_u32(head,45,7);
+	owon_put_u32(head,53,0x43FA0000ul);
+	owon_put_u32(head,65,0x41A00000ul);
+	return(fwrite((void*)head,1,OWON_HEAD_SIZE,fw) != OWON_HEAD_SIZE);
+}
@@ -0,0 +1,36 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// OWON 7102V scope BIN file (SPBS02) reader and writer, see owon.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef OWON_H_
+#define OWON_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define OWON_HEAD_SIZE 69 /* SPBS02 header size [B] */
+
+typedef struct{
+	double fs; /* sampling rate [Hz] */
+	double Ts; /* time step [s] */
+	int32_t vert_ofs; /* vertical offset [bits] */
+	double vert_scale; /* vertical scale [V/bit] */
+	size_t count; /* samples count */
+	int8_t *u; /* raw wave data (u[V] = (u - vert_ofs)*vert_scale) */
+}TOwon;
+
+// --- functions:
+int owon_read(TOwon *owon, const char *path);
+void owon_free(TOwon *owon);
+int owon_write_head(FILE *fw, double fs, uint32_t count);
+
+#endif
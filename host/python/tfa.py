@@ -0,0 +1,308 @@
+#-----------------------------------------------------------------------------
+# Python bindings of decoder of radio sensors TFA Dostmann 30.3215.02.
+# Thin ctypes wrapper of libtfa.so (host/libtfa.c), so the data are decoded
+# by the very same code as in the AVR receiver at native speed.
+#
+# Input buffers (bytes, bytearray, array.array, memoryview, NumPy arrays, ...)
+# are passed to the library by pointer obtained by buffer protocol, so they
+# are not copied. They must be C contiguous with matching item type:
+#   feed_i8 - int8 samples ('b', bytes only with signed_bytes=True, unsigned
+#             offset binary captures must be converted first)
+#   feed_i16 - int16 samples ('h')
+#   feed_f32 - float32 samples ('f')
+#   feed_low - low-pulse widths in receiver ticks (uint8)
+#   feed_raw - raw edge stream of receiver in TFA:RAW mode (bytes)
+# Decoded sensors are returned by read() as ctypes array of Sensor structs
+# (fixed 16 byte layout of TLibTfaSensor), which is buffer itself, e.g.
+# numpy.frombuffer(sensors,dtype=numpy.dtype(tfa.Sensor)) views it.
+#
+# Usage:
+#   import tfa
+#   with tfa.Decoder(fs=1e6) as dec:
+#       dec.feed(samples)
+#       dec.flush()
+#       for s in dec.read():
+#           print(s.id,s.channel,s.temperature,s.rh)
+#   tfa.parse(bytes.fromhex('2ded100909')) - parse single packet bytes
+#
+# Library is looked up in LIBTFA environment variable, then next to this
+# folder (host/libtfa.so, build by make in host) and then in system paths.
+# Run as script it decodes raw edge stream like tfa_raw:
+#   python3 tfa.py [-n] [file]
+#
+# (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+# url: https://github.com/smaslan/TFA-30321502-decoder
+# V1.0, 2023-07-27, initial version
+#
+# The code and all its part are distributed under MIT license
+# https://opensource.org/licenses/MIT.
+#-----------------------------------------------------------------------------
+
+import ctypes
+import ctypes.util
+import os
+import sys
+
+LIBTFA_ABI = 2 # ABI version of libtfa.h this wrapper is made for
+
+# sensor flags
+SYNC = 1<<6 # sync button pressed
+LOW_BATT = 1<<7 # low battery
+
+
+class Sensor(ctypes.Structure):
+    """Decoded sensor data (TLibTfaSensor), fixed-point fields as in C."""
+    _fields_ = [
+        ('temp',ctypes.c_int16), # temperature [0.1 degC]
+        ('dew',ctypes.c_int16), # dew point [0.1 degC]
+        ('ah',ctypes.c_uint16), # absolute humidity [0.01 g/m3]
+        ('hi',ctypes.c_int16), # heat index [0.1 degC]
+        ('id',ctypes.c_uint8), # random sensor 4-bit ID
+        ('channel',ctypes.c_uint8), # channel 1-3
+        ('rh',ctypes.c_uint8), # relative humidity [%]
+        ('type',ctypes.c_uint8), # sensor type
+        ('quality',ctypes.c_uint8), # link quality [%]
+        ('flags',ctypes.c_uint8), # SYNC, LOW_BATT
+        ('reserved',ctypes.c_uint8*2)]
+
+    @property
+    def temperature(self):
+        return(self.temp/10.0)
+
+    @property
+    def dew_point(self):
+        return(self.dew/10.0)
+
+    @property
+    def abs_humidity(self):
+        return(self.ah/100.0)
+
+    @property
+    def heat_index(self):
+        return(self.hi/10.0)
+
+    @property
+    def low_batt(self):
+        return(int(bool(self.flags & LOW_BATT)))
+
+    @property
+    def sync(self):
+        return(int(bool(self.flags & SYNC)))
+
+    def report(self, head=True):
+        """Sensor data in receiver report format (without LF)."""
+        if head:
+            return('id=%2u, chn=%u, t=%0.1f"C, rh=%u%%, batt=%u, sync=%u, q=%u%%' % (self.id,self.channel,self.temperature,self.rh,self.low_batt,self.sync,self.quality))
+        return('%2u, %u, %0.1f, %u, %u, %u, %u' % (self.id,self.channel,self.temperature,self.rh,self.low_batt,self.sync,self.quality))
+
+    def __repr__(self):
+        return('Sensor(%s)' % self.report())
+
+
+# --- buffer protocol access (zero-copy pointer of any exporter, also read-only ones):
+class _PyBuffer(ctypes.Structure):
+    _fields_ = [
+        ('buf',ctypes.c_void_p),
+        ('obj',ctypes.c_void_p),
+        ('len',ctypes.c_ssize_t),
+        ('itemsize',ctypes.c_ssize_t),
+        ('readonly',ctypes.c_int),
+        ('ndim',ctypes.c_int),
+        ('format',ctypes.c_char_p),
+        ('shape',ctypes.c_void_p),
+        ('strides',ctypes.c_void_p),
+        ('suboffsets',ctypes.c_void_p),
+        ('internal',ctypes.c_void_p)]
+
+_PyBUF_C_CONTIGUOUS_FORMAT = 0x0038 | 0x0004 # PyBUF_C_CONTIGUOUS | PyBUF_FORMAT
+
+_get_buffer = ctypes.pythonapi.PyObject_GetBuffer
+_get_buffer.argtypes = [ctypes.py_object,ctypes.POINTER(_PyBuffer),ctypes.c_int]
+_get_buffer.restype = ctypes.c_int
+_release_buffer = ctypes.pythonapi.PyBuffer_Release
+_release_buffer.argtypes = [ctypes.POINTER(_PyBuffer)]
+_release_buffer.restype = None
+
+class _Buffer:
+    """Holds buffer of obj for duration of with block: ptr, count of items."""
+    def __init__(self, obj, formats, itemsize):
+        self.view = _PyBuffer()
+        _get_buffer(obj,ctypes.byref(self.view),_PyBUF_C_CONTIGUOUS_FORMAT)
+        fmt = (self.view.format or b'B').decode().lstrip('@=' + ('<' if sys.byteorder == 'little' else '>'))
+        if fmt not in formats or self.view.itemsize != itemsize:
+            _release_buffer(ctypes.byref(self.view))
+            raise TypeError("buffer item format '%s' not supported, expected one of '%s'" % (fmt,formats))
+        self.ptr = self.view.buf
+        self.count = self.view.len//itemsize
+
+    def __enter__(self):
+        return(self)
+
+    def __exit__(self, *exc):
+        _release_buffer(ctypes.byref(self.view))
+
+
+# --- library:
+def _load():
+    paths = []
+    if os.environ.get('LIBTFA'):
+        paths.append(os.environ['LIBTFA'])
+    paths.append(os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),'libtfa.so'))
+    name = ctypes.util.find_library('tfa')
+    if name:
+        paths.append(name)
+    for path in paths:
+        try:
+            lib = ctypes.CDLL(path)
+            break
+        except OSError:
+            continue
+    else:
+        raise OSError('libtfa.so not found (build it by make in host or set LIBTFA)')
+    if lib.libtfa_abi() != LIBTFA_ABI:
+        raise OSError('libtfa ABI %d does not match wrapper ABI %d' % (lib.libtfa_abi(),LIBTFA_ABI))
+
+    h = ctypes.c_void_p
+    size = ctypes.c_size_t
+    ptr = ctypes.c_void_p
+    for name, res, args in [
+        ('libtfa_open',h,[ctypes.c_double]),
+        ('libtfa_close',None,[h]),
+        ('libtfa_reset',None,[h]),
+        ('libtfa_low',ctypes.c_int,[h,ptr,size]),
+        ('libtfa_raw',ctypes.c_int,[h,ptr,size]),
+        ('libtfa_i8',ctypes.c_int,[h,ptr,size]),
+        ('libtfa_i16',ctypes.c_int,[h,ptr,size,ctypes.c_int32]),
+        ('libtfa_f32',ctypes.c_int,[h,ptr,size,ctypes.c_float]),
+        ('libtfa_flush',ctypes.c_int,[h]),
+        ('libtfa_pending',size,[h]),
+        ('libtfa_read',size,[h,ctypes.POINTER(Sensor),size]),
+        ('libtfa_counts',None,[h,ctypes.POINTER(ctypes.c_uint32),ctypes.POINTER(ctypes.c_uint32),ctypes.POINTER(ctypes.c_uint32)]),
+        ('libtfa_parse',ctypes.c_int,[ptr,size,ctypes.POINTER(Sensor)])]:
+        func = getattr(lib,name)
+        func.restype = res
+        func.argtypes = args
+    return(lib)
+
+_lib = _load()
+
+def _check(res):
+    if res < 0:
+        raise RuntimeError('libtfa decoder failed (out of memory or no sample rate)')
+    return(res)
+
+
+class Decoder:
+    """Decoder instance: samples at rate fs [Hz] or edges (fs = 0)."""
+    def __init__(self, fs=0.0):
+        self._h = _lib.libtfa_open(fs)
+        if not self._h:
+            raise ValueError('invalid sample rate')
+        self.fs = fs
+
+    def close(self):
+        if self._h:
+            _lib.libtfa_close(self._h)
+            self._h = None
+
+    def __enter__(self):
+        return(self)
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def reset(self):
+        """Reset decoder state and drop unread sensors."""
+        _lib.libtfa_reset(self._h)
+
+    def feed_i8(self, x, signed_bytes=False):
+        """Feed int8 samples, returns count of decoded sensors.
+        Unsigned byte buffers (bytes, 'B') are refused unless signed_bytes=True declares they hold int8 samples."""
+        with _Buffer(x,'bc' + ('B' if signed_bytes else ''),1) as b:
+            return(_check(_lib.libtfa_i8(self._h,b.ptr,b.count)))
+
+    def feed_i16(self, x, full_scale=32768):
+        """Feed int16 samples with full_scale amplitude (e.g. 2048 for 12-bit ADC), returns count of decoded sensors."""
+        with _Buffer(x,'h',2) as b:
+            return(_check(_lib.libtfa_i16(self._h,b.ptr,b.count,int(full_scale))))
+
+    def feed_f32(self, x, full_scale=1.0):
+        """Feed float32 samples with full_scale amplitude, returns count of decoded sensors."""
+        with _Buffer(x,'f',4) as b:
+            return(_check(_lib.libtfa_f32(self._h,b.ptr,b.count,full_scale)))
+
+    def feed(self, x, full_scale=None):
+        """Feed samples of any supported type (by buffer item format), full_scale of int16 or float32 samples."""
+        fmt = memoryview(x).format.lstrip('@=<>')
+        if fmt == 'h':
+            return(self.feed_i16(x,32768 if full_scale is None else full_scale))
+        if fmt == 'f':
+            return(self.feed_f32(x,1.0 if full_scale is None else full_scale))
+        if fmt in ('b','c'):
+            return(self.feed_i8(x))
+        raise TypeError("buffer item format '%s' not supported, expected 'b', 'h' or 'f' (bytes of int8 samples: feed_i8(x,signed_bytes=True))" % fmt)
+
+    def feed_low(self, ticks):
+        """Feed low-pulse widths [receiver ticks], returns count of decoded sensors."""
+        with _Buffer(ticks,'Bbc',1) as b:
+            return(_check(_lib.libtfa_low(self._h,b.ptr,b.count)))
+
+    def feed_raw(self, data):
+        """Feed raw edge stream of receiver (TFA:RAW mode), returns count of decoded sensors."""
+        with _Buffer(data,'Bbc',1) as b:
+            return(_check(_lib.libtfa_raw(self._h,b.ptr,b.count)))
+
+    def flush(self):
+        """End of samples: finish pending pulse, returns count of decoded sensors."""
+        return(_check(_lib.libtfa_flush(self._h)))
+
+    def pending(self):
+        """Count of unread decoded sensors."""
+        return(_lib.libtfa_pending(self._h))
+
+    def read(self, count=None):
+        """Read up to count (default all) oldest decoded sensors as ctypes array of Sensor."""
+        n = self.pending() if count is None else min(count,self.pending())
+        sensors = (Sensor*n)()
+        _lib.libtfa_read(self._h,sensors,n)
+        return(sensors)
+
+    def counts(self):
+        """Decoder counters: transmissions, packets, raw stream lost edges markers."""
+        c = [ctypes.c_uint32() for k in range(3)]
+        _lib.libtfa_counts(self._h,*[ctypes.byref(v) for v in c])
+        return(tuple(v.value for v in c))
+
+
+def parse(packet):
+    """Parse single packet bytes (5 bytes as received), returns Sensor or None for other sensor type."""
+    sensor = Sensor()
+    with _Buffer(packet,'Bbc',1) as b:
+        res = _lib.libtfa_parse(b.ptr,b.count,ctypes.byref(sensor))
+    if res < 0:
+        raise ValueError('packet must be 5 bytes')
+    return(sensor if res else None)
+
+
+if __name__ == '__main__':
+    # decode raw edge stream like tfa_raw
+    args = sys.argv[1:]
+    head = '-n' not in args
+    args = [a for a in args if a != '-n']
+    if len(args) > 1:
+        sys.stderr.write('usage: %s [-n] [file]\n' % sys.argv[0])
+        sys.exit(1)
+    fr = open(args[0],'rb') if args else sys.stdin.buffer
+    buf = bytearray(256)
+    with Decoder() as dec:
+        while True:
+            size = fr.readinto(buf)
+            if not size:
+                break
+            dec.feed_raw(memoryview(buf)[:size])
+            for s in dec.read():
+                print(s.report(head),flush=True)
+        sys.stderr.write('transmissions: %u, packets: %u, lost edge markers: %u\n' % dec.counts())
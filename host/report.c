@@ -0,0 +1,27 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Sensor data reporting in the same format as tfa_print_sensor() of the AVR
+// receiver (see ../AVR/avr-tfa-rx-test/main.c), so the host tools output
+// can be ingested by the same pipeline as the receiver talk mode.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "tfa_core.h"
+#include "report.h"
+
+// print sensor data
+void report_sensor(FILE *fw, const TSensor *sensor, int head)
+{
+	if(head)
+		fprintf(fw,"id=%2u, chn=%u, t=%0.1f\"C, rh=%u%%, batt=%u, sync=%u, q=%u%%\n",sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags),sensor->quality);
+	else
+		fprintf(fw,"%2u, %u, %0.1f, %u, %u, %u, %u\n",sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags),sensor->quality);
+}
@@ -0,0 +1,23 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Sensor data reporting in the same format as the AVR receiver.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include <stdio.h>
+
+#include "tfa_core.h"
+
+// --- functions:
+void report_sensor(FILE *fw, const TSensor *sensor, int head);
+
+#endif
@@ -0,0 +1,315 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Threshold slicer of raw int8 waveforms (e.g. SPBS02 scope data).
+// Host equivalent of edge detection in ../octave/tfa.m:
+//   rise: u(k) >= trh & u(k-1) < trh
+//   fall: u(k) < trh & u(k-1) >= trh
+// Comparison produces bitmask of sample levels (32 samples per AVX2
+// compare), crossings are xor of mask with itself shifted by one sample
+// and edge indices are extracted by count trailing zeros. Edges strictly
+// alternate, so the edge type follows from the level before the first one.
+// Kernel is selected at runtime (AVX2, SSE2, scalar fallback).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+ #include <immintrin.h>
+ #define SLICER_X86
+#endif
+
+#include "slicer.h"
+
+// initialize slicer
+void slicer_init(TSlicer *sl, int8_t trh, uint8_t level)
+{
+	sl->trh = trh;
+	sl->level = !!level;
+}
+
+// scalar kernel (samples from k to n-1)
+static size_t slicer_scalar(TSlicer *sl, const int8_t *x, size_t k, size_t n, uint32_t *edges)
+{
+	size_t count = 0;
+	uint8_t level = sl->level;
+	for(;k < n;k++)
+	{
+		uint8_t now = x[k] >= sl->trh;
+		if(now != level)
+			edges[count++] = k;
+		level = now;
+	}
+	sl->level = level;
+	return(count);
+}
+
+// scalar block range
+static void slicer_range_scalar(const int8_t *x, size_t n, int8_t *xmin, int8_t *xmax)
+{
+	int8_t lo = 127, hi = -128;
+	for(size_t k = 0;k < n;k++)
+	{
+		if(x[k] < lo)
+			lo = x[k];
+		if(x[k] > hi)
+			hi = x[k];
+	}
+	*xmin = lo;
+	*xmax = hi;
+}
+
+#ifdef SLICER_X86
+
+// SSE2 block range (unsigned min/max of sign flipped samples)
+static void slicer_range_sse2(const int8_t *x, size_t n, int8_t *xmin, int8_t *xmax)
+{
+	const __m128i sign = _mm_set1_epi8((char)0x80);
+	__m128i lo = _mm_set1_epi8((char)0xFF);
+	__m128i hi = _mm_setzero_si128();
+	size_t k = 0;
+	for(;k + 16 <= n;k += 16)
+	{
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&x[k]),sign);
+		lo = _mm_min_epu8(lo,v);
+		hi = _mm_max_epu8(hi,v);
+	}
+	uint8_t blo[16], bhi[16];
+	_mm_storeu_si128((__m128i*)blo,lo);
+	_mm_storeu_si128((__m128i*)bhi,hi);
+	int8_t tlo, thi;
+	slicer_range_scalar(&x[k],n - k,&tlo,&thi);
+	for(int m = 0;m < 16;m++)
+	{
+		if((int8_t)(blo[m]^0x80) < tlo)
+			tlo = (int8_t)(blo[m]^0x80);
+		if((int8_t)(bhi[m]^0x80) > thi)
+			thi = (int8_t)(bhi[m]^0x80);
+	}
+	*xmin = tlo;
+	*xmax = thi;
+}
+
+// AVX2 block range
+__attribute__((target("avx2")))
+static void slicer_range_avx2(const int8_t *x, size_t n, int8_t *xmin, int8_t *xmax)
+{
+	__m256i lo = _mm256_set1_epi8(127);
+	__m256i hi = _mm256_set1_epi8(-128);
+	size_t k = 0;
+	for(;k + 32 <= n;k += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)&x[k]);
+		lo = _mm256_min_epi8(lo,v);
+		hi = _mm256_max_epi8(hi,v);
+	}
+	int8_t blo[32], bhi[32];
+	_mm256_storeu_si256((__m256i*)blo,lo);
+	_mm256_storeu_si256((__m256i*)bhi,hi);
+	int8_t tlo, thi;
+	slicer_range_scalar(&x[k],n - k,&tlo,&thi);
+	for(int m = 0;m < 32;m++)
+	{
+		if(blo[m] < tlo)
+			tlo = blo[m];
+		if(bhi[m] > thi)
+			thi = bhi[m];
+	}
+	*xmin = tlo;
+	*xmax = thi;
+}
+
+// SSE2 kernel, 16 samples per compare
+static size_t slicer_sse2(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges)
+{
+	const __m128i trh = _mm_set1_epi8(sl->trh);
+	size_t count = 0;
+	uint32_t level = sl->level;
+	size_t k = 0;
+	for(;k + 16 <= n;k += 16)
+	{
+		// levels: !(trh > x)
+		__m128i v = _mm_loadu_si128((const __m128i*)&x[k]);
+		uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(trh,v)) & 0xFFFFu;
+		uint32_t cross = (mask ^ ((mask << 1) | level)) & 0xFFFFu;
+		level = mask >> 15;
+		while(cross)
+		{
+			edges[count++] = k + __builtin_ctz(cross);
+			cross &= cross - 1;
+		}
+	}
+	sl->level = level;
+	return(count + slicer_scalar(sl,x,k,n,&edges[count]));
+}
+
+// AVX2 kernel, 2x32 samples per loop
+__attribute__((target("avx2,bmi")))
+static size_t slicer_avx2(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges)
+{
+	const __m256i trh = _mm256_set1_epi8(sl->trh);
+	size_t count = 0;
+	uint64_t level = sl->level;
+	size_t k = 0;
+	for(;k + 64 <= n;k += 64)
+	{
+		// levels: !(trh > x)
+		__m256i v0 = _mm256_loadu_si256((const __m256i*)&x[k]);
+		__m256i v1 = _mm256_loadu_si256((const __m256i*)&x[k + 32]);
+		uint32_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(trh,v0));
+		uint32_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(trh,v1));
+		uint64_t mask = ~((uint64_t)m0 | ((uint64_t)m1 << 32));
+		uint64_t cross = mask ^ ((mask << 1) | level);
+		level = mask >> 63;
+		while(cross)
+		{
+			edges[count++] = k + _tzcnt_u64(cross);
+			cross &= cross - 1;
+		}
+	}
+	sl->level = level;
+	return(count + slicer_scalar(sl,x,k,n,&edges[count]));
+}
+
+#endif
+
+// scalar kernel for whole buffer
+static size_t slicer_plain(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges)
+{
+	return(slicer_scalar(sl,x,0,n,edges));
+}
+
+// kernel selection
+typedef size_t (*TSlicerKernel)(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges);
+typedef void (*TSlicerRange)(const int8_t *x, size_t n, int8_t *xmin, int8_t *xmax);
+static TSlicerKernel slicer_kernel = NULL;
+static TSlicerRange slicer_range = slicer_range_scalar;
+static const char *slicer_kernel_isa = "scalar";
+
+static void slicer_select(void)
+{
+	slicer_kernel = slicer_plain;
+#ifdef SLICER_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+	{
+		slicer_kernel = slicer_avx2;
+		slicer_range = slicer_range_avx2;
+		slicer_kernel_isa = "avx2";
+	}
+	else if(__builtin_cpu_supports("sse2"))
+	{
+		slicer_kernel = slicer_sse2;
+		slicer_range = slicer_range_sse2;
+		slicer_kernel_isa = "sse2";
+	}
+#endif
+}
+
+// force kernel by name ("avx2", "sse2", "scalar"), returns 0 if supported
+int slicer_use(const char *isa)
+{
+	slicer_select();
+	if(!strcmp(isa,"scalar"))
+	{
+		slicer_kernel = slicer_plain;
+		slicer_range = slicer_range_scalar;
+		slicer_kernel_isa = "scalar";
+		return(0);
+	}
+#ifdef SLICER_X86
+	if(!strcmp(isa,"sse2") && __builtin_cpu_supports("sse2"))
+	{
+		slicer_kernel = slicer_sse2;
+		slicer_range = slicer_range_sse2;
+		slicer_kernel_isa = "sse2";
+		return(0);
+	}
+	if(!strcmp(isa,"avx2") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+	{
+		slicer_kernel = slicer_avx2;
+		slicer_range = slicer_range_avx2;
+		slicer_kernel_isa = "avx2";
+		return(0);
+	}
+#endif
+	return(1);
+}
+
+// slice n samples, stores indices of level changes to edges (must hold n items), returns edges count
+size_t slicer_i8(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges)
+{
+	if(!slicer_kernel)
+		slicer_select();
+	return(slicer_kernel(sl,x,n,edges));
+}
+
+// get name of used kernel
+const char *slicer_isa(void)
+{
+	if(!slicer_kernel)
+		slicer_select();
+	return(slicer_kernel_isa);
+}
+
+// initialize threshold tracker
+//  decay: envelope decays by 1/2^decay of its distance to block range per block
+//  swing: minimum envelope swing to slice, otherwise all samples are low
+void slicer_track_init(TSlicerTrack *tr, uint8_t decay, uint8_t swing)
+{
+	tr->env_min = 127*256;
+	tr->env_max = -128*256;
+	tr->decay = decay;
+	tr->swing = swing;
+}
+
+// slice n samples with threshold tracking, stores indices of level changes to edges (must hold n items), returns edges count
+//  Threshold is in the middle of decaying min/max envelope. Envelope follows block range
+//  instantly when it grows and decays slowly otherwise, so single pass over arbitrary long
+//  or live waveform is possible and slicer adapts to signal strength changes.
+size_t slicer_track_i8(TSlicer *sl, TSlicerTrack *tr, const int8_t *x, size_t n, uint32_t *edges)
+{
+	if(!slicer_kernel)
+		slicer_select();
+	size_t count = 0;
+	for(size_t k = 0;k < n;k += SLICER_BLOCK)
+	{
+		size_t size = n - k;
+		if(size > SLICER_BLOCK)
+			size = SLICER_BLOCK;
+
+		// update envelope [1/256 bit]
+		int8_t xmin, xmax;
+		slicer_range(&x[k],size,&xmin,&xmax);
+		int32_t bmin = xmin*256, bmax = xmax*256;
+		if(bmax >= tr->env_max)
+			tr->env_max = bmax;
+		else
+			tr->env_max -= (tr->env_max - bmax) >> tr->decay;
+		if(bmin <= tr->env_min)
+			tr->env_min = bmin;
+		else
+			tr->env_min += (bmin - tr->env_min) >> tr->decay;
+
+		// threshold in the middle of envelope, all low if too small swing
+		int32_t trh = (tr->env_max + tr->env_min + 256)/512;
+		if(tr->env_max - tr->env_min < tr->swing*256)
+			trh = 127;
+		sl->trh = (int8_t)trh;
+
+		// slice block
+		size_t part = slicer_kernel(sl,&x[k],size,&edges[count]);
+		for(size_t m = count;m < count + part;m++)
+			edges[m] += k;
+		count += part;
+	}
+	return(count);
+}
@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Threshold slicer of int8 waveforms (SIMD), see slicer.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef SLICER_H_
+#define SLICER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// slicer state (carried between calls)
+typedef struct{
+	int8_t trh; /* threshold level, sample is high if >= trh */
+	uint8_t level; /* level of last processed sample (0 or 1) */
+}TSlicer;
+
+#define SLICER_BLOCK 256 /* threshold tracker block size [samples] */
+
+// threshold tracker state (decaying min/max envelope)
+typedef struct{
+	int32_t env_min; /* envelope minimum [1/256 bit] */
+	int32_t env_max; /* envelope maximum [1/256 bit] */
+	uint8_t decay; /* envelope decay 1/2^decay per block */
+	uint8_t swing; /* minimum envelope swing to slice [bit] */
+}TSlicerTrack;
+
+// --- functions:
+void slicer_init(TSlicer *sl, int8_t trh, uint8_t level);
+size_t slicer_i8(TSlicer *sl, const int8_t *x, size_t n, uint32_t *edges);
+const char *slicer_isa(void);
+int slicer_use(const char *isa);
+void slicer_track_init(TSlicerTrack *tr, uint8_t decay, uint8_t swing);
+size_t slicer_track_i8(TSlicer *sl, TSlicerTrack *tr, const int8_t *x, size_t n, uint32_t *edges);
+
+#endif
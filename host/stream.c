@@ -0,0 +1,116 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Streaming (push style) decoder of demodulated ASK waveform, e.g. output
+// of RX module sampled by ADC or envelope from software radio.
+//
+// Caller feeds chunks of any size of int8, int16 or float samples, decoded
+// sensors are reported via callback. All state (slicer level, threshold
+// envelope, position of last edge, partial packets) is carried across the
+// chunks, so the stream can be decoded continuously in constant memory.
+// Samples are sliced by threshold tracking slicer (slicer.c), low-pulse
+// widths are converted to receiver ticks and fed to the same decoder core
+// as the AVR receiver (dec.c). int16 and float samples are converted to
+// int8 first (int16: upper byte, float: +-full_scale to +-127).
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+#include "slicer.h"
+#include "stream.h"
+
+// initialize stream decoder for sampling rate fs [Hz]
+void stream_init(TStream *st, double fs, TDecSensorCb cb, void *user)
+{
+	st->ticks_per_sample = 1.0/(fs*TFA_TICK_REAL);
+	slicer_init(&st->sl,0,0);
+	double blocks = STREAM_TAU*fs/SLICER_BLOCK;
+	slicer_track_init(&st->tr,(blocks > 1.0) ? (uint8_t)lround(log2(blocks)) : 0,STREAM_SWING);
+	st->pos = 0;
+	st->last = 0;
+	dec_init(&st->dec,cb,user);
+}
+
+// feed low-pulse of given length [samples] to decoder
+static void stream_low(TStream *st, uint64_t samples)
+{
+	double ticks = samples*st->ticks_per_sample + 0.5;
+	dec_low(&st->dec,(ticks >= 255.0) ? 255 : (uint8_t)ticks);
+}
+
+// process int8 samples
+void stream_i8(TStream *st, const int8_t *x, size_t n)
+{
+	while(n)
+	{
+		size_t size = (n > STREAM_CHUNK) ? STREAM_CHUNK : n;
+		uint8_t level = st->sl.level;
+		size_t count = slicer_track_i8(&st->sl,&st->tr,x,size,st->edges);
+		for(size_t k = 0;k < count;k++)
+		{
+			uint64_t edge = st->pos + st->edges[k];
+			if(!level)
+				stream_low(st,edge - st->last);
+			level = !level;
+			st->last = edge;
+		}
+		st->pos += size;
+		x += size;
+		n -= size;
+	}
+}
+
+// process int16 samples in range +-full_scale (32768 for 16-bit, 2048 for 12-bit ADC data, ...)
+void stream_i16(TStream *st, const int16_t *x, size_t n, int32_t full_scale)
+{
+	int64_t gain = (128ll << 16)/full_scale; // 16.16 fixed point, full_scale 32768 is plain x >> 8
+	while(n)
+	{
+		size_t size = (n > STREAM_CHUNK) ? STREAM_CHUNK : n;
+		for(size_t k = 0;k < size;k++)
+		{
+			int64_t v = (x[k]*gain) >> 16;
+			st->conv[k] = (int8_t)((v > 127) ? 127 : ((v < -128) ? -128 : v));
+		}
+		stream_i8(st,st->conv,size);
+		x += size;
+		n -= size;
+	}
+}
+
+// process float samples in range +-full_scale
+void stream_f32(TStream *st, const float *x, size_t n, float full_scale)
+{
+	float gain = 127.0f/full_scale;
+	while(n)
+	{
+		size_t size = (n > STREAM_CHUNK) ? STREAM_CHUNK : n;
+		for(size_t k = 0;k < size;k++)
+		{
+			float v = x[k]*gain;
+			v = (v > 127.0f) ? 127.0f : ((v < -128.0f) ? -128.0f : v);
+			st->conv[k] = (int8_t)lrintf(v);
+		}
+		stream_i8(st,st->conv,size);
+		x += size;
+		n -= size;
+	}
+}
+
+// end of stream: finish pending transmission (receiver waits for any edge after gap)
+void stream_flush(TStream *st)
+{
+	if(!st->sl.level)
+		stream_low(st,st->pos - st->last);
+	st->last = st->pos;
+}
@@ -0,0 +1,45 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Streaming (push style) waveform decoder, see stream.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+#include "slicer.h"
+
+#define STREAM_CHUNK 4096 /* internal processing chunk [samples] */
+#define STREAM_TAU 0.5 /* threshold tracker envelope decay time constant [s] */
+#define STREAM_SWING 16 /* threshold tracker minimum signal swing [int8 bit] */
+
+typedef struct{
+	double ticks_per_sample; /* receiver ticks per sample */
+	TSlicer sl; /* threshold slicer */
+	TSlicerTrack tr; /* threshold tracker */
+	uint64_t pos; /* absolute position of next sample */
+	uint64_t last; /* absolute position of last edge */
+	TDec dec; /* edge decoder */
+	uint32_t edges[STREAM_CHUNK]; /* edges buffer */
+	int8_t conv[STREAM_CHUNK]; /* sample conversion buffer */
+}TStream;
+
+// --- functions:
+void stream_init(TStream *st, double fs, TDecSensorCb cb, void *user);
+void stream_i8(TStream *st, const int8_t *x, size_t n);
+void stream_i16(TStream *st, const int16_t *x, size_t n, int32_t full_scale);
+void stream_f32(TStream *st, const float *x, size_t n, float full_scale);
+void stream_flush(TStream *st);
+
+#endif
@@ -0,0 +1,344 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Synthetic TFA 30.3215.02 transmission generator for load and accuracy
+// testing of decoders.
+//
+// Timeline is split to independent slots. Each slot contains single
+// transmission (7 repetitions of packet) of each of configured number of
+// sensors with random content, random start offset (overlapping sensors),
+// random clock drift and gaussian jitter of all pulse and gap widths.
+// Random glitch pulses are added over the whole slot. Overlapping signals
+// are combined as OR (ASK). Slot is finally rendered as int8 waveform with
+// gaussian noise (SPBS02 scope or plain samples) or encoded as raw edge
+// stream of the AVR receiver (TFA:RAW mode coding).
+//
+// Slot content depends only on its seed, so slots can be generated by
+// many threads in parallel and reproduced later.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tfa_core.h"
+#include "synth.h"
+
+#define SYNTH_LEAD 20e-3 /* silence before first transmission in slot [s] */
+#define SYNTH_TAIL 50e-3 /* silence after last transmission in slot [s] */
+
+// xorshift64* random generator
+static uint64_t synth_rand(uint64_t *state)
+{
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return(x*0x2545F4914F6CDD1Dull);
+}
+
+// seed random generator (any seed incl. 0)
+static uint64_t synth_seed(uint64_t seed)
+{
+	// splitmix64 step
+	uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+	z ^= z >> 31;
+	return(z ? z : 1);
+}
+
+// uniform random (0,1)
+static double synth_uni(uint64_t *state)
+{
+	return(((synth_rand(state) >> 11) + 0.5)*(1.0/9007199254740992.0));
+}
+
+// gaussian random (Box-Muller)
+static double synth_gauss(uint64_t *state)
+{
+	return(sqrt(-2.0*log(synth_uni(state)))*cos(2.0*M_PI*synth_uni(state)));
+}
+
+// default setup: clean single sensor, 500kSa/s as OWON captures
+void synth_defaults(TSynthCfg *cfg)
+{
+	memset((void*)cfg,0,sizeof(TSynthCfg));
+	cfg->fs = 500e3;
+	cfg->pulse = SYNTH_T_PULSE;
+	cfg->glitch_width = TFA_T_GLITCH;
+	cfg->sensors = 1;
+	cfg->low = -99;
+	cfg->high = 80;
+}
+
+// initialize generator
+void synth_init(TSynth *syn, const TSynthCfg *cfg)
+{
+	syn->cfg = *cfg;
+	if(syn->cfg.sensors < 0)
+		syn->cfg.sensors = 0;
+	if(syn->cfg.sensors > SYNTH_SENSORS)
+		syn->cfg.sensors = SYNTH_SENSORS;
+
+	// slot duration: longest transmission (all bits high) with margin for drift and jitter
+	double pulse = cfg->pulse + 4.0*cfg->jitter;
+	double tx = pulse + TFA_PACKETS*(SYNTH_T_START + TFA_BITS*(pulse + TFA_T_LONG + 4.0*cfg->jitter) + pulse + SYNTH_T_STOP + pulse + 8.0*cfg->jitter);
+	syn->slot = SYNTH_LEAD + cfg->overlap + tx*(1.0 + 1e-6*fabs(cfg->drift)) + SYNTH_TAIL;
+
+	// noise table
+	uint64_t state = synth_seed(0x5EED);
+	for(int k = 0;k < SYNTH_NOISE_TAB;k++)
+		syn->noise[k] = (int16_t)lround(cfg->noise*synth_gauss(&state));
+}
+
+// make 36-bit packet word of sensor, bit 0 is the last transmitted (see tfa_parse())
+uint64_t synth_word(const TSynthSensor *sensor)
+{
+	uint64_t word = TFA_FIELD_WORD(TFA_F_RH,sensor->rh);
+	word |= TFA_FIELD_WORD(TFA_F_TEMP,sensor->temp);
+	word |= TFA_FIELD_WORD(TFA_F_CHANNEL,sensor->channel - 1);
+	word |= TFA_FIELD_WORD(TFA_F_FLAGS,sensor->flags & (TFA_SYNC | TFA_LOW_BATT));
+	word |= TFA_FIELD_WORD(TFA_F_ID,sensor->id);
+	word |= TFA_FIELD_WORD(TFA_F_TYPE,TFA_TYPE);
+	return(word);
+}
+
+// high level interval
+typedef struct{
+	double on;
+	double off;
+}TSynthPulse;
+
+static int synth_pulse_cmp(const void *a, const void *b)
+{
+	double d = ((const TSynthPulse*)a)->on - ((const TSynthPulse*)b)->on;
+	return((d > 0.0) - (d < 0.0));
+}
+
+// jittered and drifted width [s]
+static double synth_width(const TSynth *syn, uint64_t *state, double width, double scale)
+{
+	width = width*scale + syn->cfg.jitter*synth_gauss(state);
+	return((width < 1e-6) ? 1e-6 : width);
+}
+
+// generate slot of given seed, returns 0 if ok
+int synth_slot(const TSynth *syn, uint64_t seed, TSynthSlot *slot)
+{
+	const TSynthCfg *cfg = &syn->cfg;
+	uint64_t state = synth_seed(seed);
+
+	slot->duration = syn->slot;
+	slot->sensors = cfg->sensors;
+	slot->edges = 0;
+	slot->edge = NULL;
+
+	// glitches count (Poisson process)
+	size_t glitches = 0;
+	double *glitch = NULL;
+	if(cfg->glitch_rate > 0.0)
+	{
+		size_t size = (size_t)(cfg->glitch_rate*syn->slot*2.0) + 16;
+		glitch = (double*)malloc(size*sizeof(double));
+		if(!glitch)
+			return(1);
+		double t = 0.0;
+		while(glitches < size)
+		{
+			t -= log(synth_uni(&state))/cfg->glitch_rate;
+			if(t >= syn->slot)
+				break;
+			glitch[glitches++] = t;
+		}
+	}
+
+	// high pulses of all sensors and glitches
+	size_t size = (size_t)cfg->sensors*(1 + TFA_PACKETS*(TFA_BITS + 2)) + glitches;
+	TSynthPulse *pulse = (TSynthPulse*)malloc((size ? size : 1)*sizeof(TSynthPulse));
+	slot->edge = (TSynthEdge*)malloc((2*size + 1)*sizeof(TSynthEdge));
+	if(!pulse || !slot->edge)
+	{
+		free((void*)glitch);
+		free((void*)pulse);
+		synth_slot_free(slot);
+		return(1);
+	}
+	size_t count = 0;
+	for(int s = 0;s < cfg->sensors;s++)
+	{
+		// random sensor
+		TSynthSensor *sensor = &slot->sensor[s];
+		sensor->id = synth_rand(&state) & 0x0F;
+		sensor->channel = 1 + synth_rand(&state)%3;
+		sensor->temp = (int16_t)(synth_rand(&state)%1001) - 400;
+		sensor->rh = 10 + synth_rand(&state)%90;
+		sensor->flags = ((synth_uni(&state) < 0.1) ? TFA_LOW_BATT : 0) | ((synth_uni(&state) < 0.2) ? TFA_SYNC : 0);
+		sensor->t_start = SYNTH_LEAD + ((s > 0) ? cfg->overlap*synth_uni(&state) : 0.0);
+		double scale = 1.0 + 1e-6*cfg->drift*(2.0*synth_uni(&state) - 1.0);
+		uint64_t word = synth_word(sensor);
+
+		// transmission: (H, start L, 36x(H, bit L), H, stop L) x 7, H
+		double t = sensor->t_start;
+		for(int p = 0;p <= TFA_PACKETS;p++)
+		{
+			pulse[count].on = t;
+			t += synth_width(syn,&state,cfg->pulse,scale);
+			pulse[count++].off = t;
+			if(p == TFA_PACKETS)
+				break;
+			t += synth_width(syn,&state,SYNTH_T_START,scale);
+			for(int b = TFA_BITS-1;b >= 0;b--)
+			{
+				pulse[count].on = t;
+				t += synth_width(syn,&state,cfg->pulse,scale);
+				pulse[count++].off = t;
+				t += synth_width(syn,&state,((word >> b) & 1) ? TFA_T_LONG : TFA_T_SHORT,scale);
+			}
+			pulse[count].on = t;
+			t += synth_width(syn,&state,cfg->pulse,scale);
+			pulse[count++].off = t;
+			t += synth_width(syn,&state,SYNTH_T_STOP,scale);
+		}
+	}
+	for(size_t k = 0;k < glitches;k++)
+	{
+		pulse[count].on = glitch[k];
+		pulse[count++].off = glitch[k] + cfg->glitch_width*synth_uni(&state);
+	}
+	free((void*)glitch);
+
+	// combine overlapping pulses (OR) to level changes
+	qsort((void*)pulse,count,sizeof(TSynthPulse),synth_pulse_cmp);
+	for(size_t k = 0;k < count;)
+	{
+		double on = pulse[k].on;
+		double off = pulse[k].off;
+		for(k++;k < count && pulse[k].on <= off;k++)
+			if(pulse[k].off > off)
+				off = pulse[k].off;
+		if(off > syn->slot)
+			off = syn->slot;
+		if(on >= off)
+			continue;
+		slot->edge[slot->edges].t = on;
+		slot->edge[slot->edges++].level = 1;
+		slot->edge[slot->edges].t = off;
+		slot->edge[slot->edges++].level = 0;
+	}
+	free((void*)pulse);
+	return(0);
+}
+
+// release slot
+void synth_slot_free(TSynthSlot *slot)
+{
+	free((void*)slot->edge);
+	slot->edge = NULL;
+	slot->edges = 0;
+}
+
+// samples count of slot
+size_t synth_samples(const TSynth *syn)
+{
+	return((size_t)ceil(syn->slot*syn->cfg.fs));
+}
+
+// render slot to int8 waveform with noise, x must hold synth_samples() items
+void synth_render(const TSynth *syn, uint64_t seed, const TSynthSlot *slot, int8_t *x)
+{
+	const TSynthCfg *cfg = &syn->cfg;
+	size_t n = synth_samples(syn);
+	uint64_t state = synth_seed(~seed);
+	size_t k = 0;
+	for(size_t e = 0;e <= slot->edges;e++)
+	{
+		// fill run up to next edge
+		size_t end = (e < slot->edges) ? (size_t)ceil(slot->edge[e].t*cfg->fs) : n;
+		if(end > n)
+			end = n;
+		int16_t level = (e > 0 && slot->edge[e-1].level) ? cfg->high : cfg->low;
+		if(cfg->noise <= 0.0)
+		{
+			if(end > k)
+				memset((void*)&x[k],(int8_t)level,end - k);
+			k = (end > k) ? end : k;
+			continue;
+		}
+		uint64_t rnd = 0;
+		for(int m = 0;k < end;k++,m--)
+		{
+			if(m <= 0)
+			{
+				rnd = synth_rand(&state);
+				m = 4;
+			}
+			int16_t v = level + syn->noise[rnd & (SYNTH_NOISE_TAB-1)];
+			rnd >>= 16;
+			x[k] = (int8_t)((v > 127) ? 127 : ((v < -128) ? -128 : v));
+		}
+	}
+}
+
+// store raw edge stream symbol
+static size_t synth_raw_put(uint8_t *out, uint32_t ticks, uint8_t is_high)
+{
+	if(ticks > 255)
+		ticks = 255;
+	uint8_t code = (ticks & TFA_RAW_MASK) | (is_high ? TFA_RAW_HIGH : 0);
+	if(ticks > TFA_RAW_MASK)
+	{
+		out[0] = code | TFA_RAW_MORE;
+		out[1] = ticks >> 6;
+		return(2);
+	}
+	out[0] = code;
+	return(1);
+}
+
+// max raw edge stream size of slot [bytes] (see synth_raw())
+//  Each level is single symbol of max 2 bytes (longer levels saturate at 255 ticks), so the size
+//  depends on edges only, not on sample rate.
+size_t synth_raw_size(const TSynthSlot *slot)
+{
+	return(2*(slot->edges + 1));
+}
+
+// encode slot as raw edge stream of receiver (TFA:RAW), out must hold synth_raw_size() bytes, returns stream size
+//  Edges are quantized to receiver ticks as sampled by tick ISR, so pulses shorter than tick may
+//  disappear as in receiver. Slot starts and ends with long silence, so the stream of slot starts
+//  by the first high pulse and ends by saturated low (silence at slot start is part of it), so the
+//  slots can be simply concatenated and the last transmission is complete.
+size_t synth_raw(const TSynthSlot *slot, uint8_t *out)
+{
+	// tick of each edge (first tick sampling the new level), pair of edges in the same tick cancels
+	uint32_t *tick = (uint32_t*)malloc((slot->edges + 1)*sizeof(uint32_t));
+	if(!tick)
+		return(0);
+	size_t count = 0;
+	for(size_t e = 0;e < slot->edges;e++)
+	{
+		uint32_t now = (uint32_t)ceil(slot->edge[e].t/TFA_TICK_REAL);
+		if(count && tick[count-1] == now)
+			count--;
+		else
+			tick[count++] = now;
+	}
+
+	// durations of levels before each edge
+	size_t size = 0;
+	for(size_t e = 1;e < count;e++)
+		size += synth_raw_put(&out[size],tick[e] - tick[e-1],e & 1);
+	if(count)
+		size += synth_raw_put(&out[size],255,0);
+	free((void*)tick);
+	return(size);
+}
@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+// Part of host tools for radio sensors TFA Dostmann 30.3215.02.
+// Synthetic TFA 30.3215.02 transmission generator, see synth.c.
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#ifndef SYNTH_H_
+#define SYNTH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tfa_core.h"
+
+// transmission timing as measured on real sensors (see ../data)
+#define SYNTH_T_PULSE 0.5e-3 /* high pulse width [s] */
+#define SYNTH_T_START 8.4e-3 /* start-low pulse [s] */
+#define SYNTH_T_STOP 1.0e-3 /* stop-low pulse [s] */
+
+#define SYNTH_SENSORS 8 /* max sensors per slot */
+#define SYNTH_NOISE_TAB 65536 /* noise table size (power of 2) */
+
+// generator setup
+typedef struct{
+	double fs; /* sampling rate [Hz] */
+	double pulse; /* high pulse width [s] */
+	double jitter; /* gaussian jitter of pulse and gap widths (sigma) [s] */
+	double noise; /* gaussian noise of samples (sigma) [int8 bit] */
+	double glitch_rate; /* random glitch pulses rate [1/s] */
+	double glitch_width; /* max glitch pulse width [s] */
+	double drift; /* max sensor clock drift, random per sensor [ppm] */
+	double overlap; /* max random start offset of sensors in slot [s] */
+	int sensors; /* transmitting sensors per slot (>1 for overlaps) */
+	int8_t low; /* low level [int8 bit] */
+	int8_t high; /* high level [int8 bit] */
+}TSynthCfg;
+
+// generated sensor
+typedef struct{
+	uint8_t id;
+	uint8_t channel;
+	int16_t temp; /* temperature [0.1 degC] */
+	uint8_t rh;
+	uint8_t flags; /* TFA_LOW_BATT, TFA_SYNC */
+	double t_start; /* transmission start in slot [s] */
+}TSynthSensor;
+
+// level change
+typedef struct{
+	double t; /* time from slot start [s] */
+	uint8_t level; /* new level */
+}TSynthEdge;
+
+// generated slot (one transmission of each sensor followed by silence)
+typedef struct{
+	double duration; /* slot duration [s] */
+	int sensors;
+	TSynthSensor sensor[SYNTH_SENSORS];
+	size_t edges;
+	TSynthEdge *edge;
+}TSynthSlot;
+
+// generator context
+typedef struct{
+	TSynthCfg cfg;
+	double slot; /* slot duration [s] */
+	int16_t noise[SYNTH_NOISE_TAB]; /* noise table [int8 bit] */
+}TSynth;
+
+// --- functions:
+void synth_defaults(TSynthCfg *cfg);
+void synth_init(TSynth *syn, const TSynthCfg *cfg);
+uint64_t synth_word(const TSynthSensor *sensor);
+int synth_slot(const TSynth *syn, uint64_t seed, TSynthSlot *slot);
+void synth_slot_free(TSynthSlot *slot);
+size_t synth_samples(const TSynth *syn);
+void synth_render(const TSynth *syn, uint64_t seed, const TSynthSlot *slot, int8_t *x);
+size_t synth_raw_size(const TSynthSlot *slot);
+size_t synth_raw(const TSynthSlot *slot, uint8_t *out);
+
+#endif
@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+// Decoder accuracy and speed benchmark for TFA Dostmann 30.3215.02.
+// Sweeps sample noise, gap jitter and glitch rate of synthetic transmissions
+// (synth.c) and decodes them by streaming decoder (stream.c) with each of
+// packet election variants (dec.c). Generated slots are identical for all
+// variants. For each point it reports:
+//   decode rate - correctly decoded transmissions / transmissions
+//   false rate - decoded sensors not matching any generated / transmissions
+//   CPU time per transmission - decoder thread CPU time (excl. generation)
+// Output is tab separated table with header line (one row per point and
+// variant), so results can be tracked across receiver firmware releases.
+//
+// Usage:
+//   tfa_bench [-n transmissions] [-S seed] [-a]
+//     -n - transmissions per point (default 100)
+//     -S - random seed (default 1)
+//     -a - full grid of noise x jitter x glitch rate (default separate sweeps)
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+#include "stream.h"
+#include "synth.h"
+
+// sweep points
+static const double bench_noise[] = {0.0,20.0,40.0,60.0,80.0,100.0}; /* [int8 bit], signal swing is 179 */
+static const double bench_jitter[] = {0.0,100e-6,200e-6,300e-6,400e-6}; /* [s] */
+static const double bench_glitch[] = {0.0,2.0,10.0,50.0,200.0}; /* [1/s] */
+#define BENCH_COUNT(list) (sizeof(list)/sizeof(list[0]))
+
+// decoder variants
+static const struct{uint8_t mode; const char *name;} bench_variant[] = {{DEC_ELECT,"elect"},{DEC_MAJORITY,"majority"}};
+#define BENCH_VARIANTS BENCH_COUNT(bench_variant)
+
+#define BENCH_DECODED 16 /* max decoded sensors per slot */
+
+// decoded sensors of current slot
+typedef struct{
+	int count;
+	TSensor sensor[BENCH_DECODED];
+}TBenchSlot;
+
+static void on_sensor(const TSensor *sensor, void *user)
+{
+	TBenchSlot *res = (TBenchSlot*)user;
+	if(res->count < BENCH_DECODED)
+		res->sensor[res->count++] = *sensor;
+}
+
+// decoded sensor matches generated?
+static int bench_match(const TSensor *dec, const TSynthSensor *gen)
+{
+	return(dec->id == gen->id && dec->channel == gen->channel && dec->temp == gen->temp && dec->rh == gen->rh
+		&& (dec->flags & (TFA_SYNC | TFA_LOW_BATT)) == gen->flags);
+}
+
+// thread CPU time [s]
+static double bench_cpu(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID,&t);
+	return(t.tv_sec + 1e-9*t.tv_nsec);
+}
+
+// run single point
+static int bench_point(double noise, double jitter, double glitch, unsigned count, uint64_t seed)
+{
+	TSynthCfg cfg;
+	synth_defaults(&cfg);
+	cfg.noise = noise;
+	cfg.jitter = jitter;
+	cfg.glitch_rate = glitch;
+	static TSynth syn;
+	synth_init(&syn,&cfg);
+
+	size_t samples = synth_samples(&syn);
+	int8_t *x = (int8_t*)malloc(samples);
+	if(!x)
+		return(1);
+
+	static TStream st[BENCH_VARIANTS];
+	TBenchSlot res[BENCH_VARIANTS];
+	unsigned ok[BENCH_VARIANTS], fail[BENCH_VARIANTS];
+	double cpu[BENCH_VARIANTS];
+	for(size_t v = 0;v < BENCH_VARIANTS;v++)
+	{
+		stream_init(&st[v],cfg.fs,on_sensor,(void*)&res[v]);
+		st[v].dec.mode = bench_variant[v].mode;
+		ok[v] = 0;
+		fail[v] = 0;
+		cpu[v] = 0.0;
+	}
+
+	unsigned tx = 0;
+	for(unsigned k = 0;k < count;k++)
+	{
+		TSynthSlot slot;
+		if(synth_slot(&syn,seed*0x100000001B3ull + k,&slot))
+		{
+			free((void*)x);
+			return(1);
+		}
+		synth_render(&syn,seed*0x100000001B3ull + k,&slot,x);
+		tx += slot.sensors;
+		for(size_t v = 0;v < BENCH_VARIANTS;v++)
+		{
+			// decode slot
+			res[v].count = 0;
+			double t0 = bench_cpu();
+			stream_i8(&st[v],x,samples);
+			stream_flush(&st[v]);
+			cpu[v] += bench_cpu() - t0;
+
+			// evaluate
+			for(int d = 0;d < res[v].count;d++)
+			{
+				int match = 0;
+				for(int s = 0;s < slot.sensors && !match;s++)
+					match = bench_match(&res[v].sensor[d],&slot.sensor[s]);
+				if(match)
+					ok[v]++;
+				else
+					fail[v]++;
+			}
+		}
+		synth_slot_free(&slot);
+	}
+	free((void*)x);
+
+	for(size_t v = 0;v < BENCH_VARIANTS;v++)
+		printf("%s\t%.1f\t%.6f\t%.1f\t%u\t%u\t%u\t%.4f\t%.4f\t%.1f\n",bench_variant[v].name,noise,jitter,glitch,tx,ok[v],fail[v],
+			(double)ok[v]/tx,(double)fail[v]/tx,1e6*cpu[v]/tx);
+	fflush(stdout);
+	return(0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned count = 100;
+	uint64_t seed = 1;
+	int grid = 0;
+	for(int k = 1;k < argc;k++)
+	{
+		if(!strcmp(argv[k],"-n") && k + 1 < argc)
+			count = (unsigned)atoi(argv[++k]);
+		else if(!strcmp(argv[k],"-S") && k + 1 < argc)
+			seed = strtoull(argv[++k],NULL,10);
+		else if(!strcmp(argv[k],"-a"))
+			grid = 1;
+		else
+		{
+			fprintf(stderr,"usage: %s [-n transmissions] [-S seed] [-a]\n",argv[0]);
+			return(1);
+		}
+	}
+
+	printf("variant\tnoise\tjitter\tglitch_rate\ttransmissions\tdecoded\tfalse\tdecode_rate\tfalse_rate\tcpu_us_per_tx\n");
+	int err = 0;
+	if(grid)
+	{
+		for(size_t n = 0;n < BENCH_COUNT(bench_noise);n++)
+			for(size_t j = 0;j < BENCH_COUNT(bench_jitter);j++)
+				for(size_t g = 0;g < BENCH_COUNT(bench_glitch);g++)
+					err |= bench_point(bench_noise[n],bench_jitter[j],bench_glitch[g],count,seed);
+	}
+	else
+	{
+		for(size_t n = 0;n < BENCH_COUNT(bench_noise);n++)
+			err |= bench_point(bench_noise[n],0.0,0.0,count,seed);
+		for(size_t j = 1;j < BENCH_COUNT(bench_jitter);j++)
+			err |= bench_point(0.0,bench_jitter[j],0.0,count,seed);
+		for(size_t g = 1;g < BENCH_COUNT(bench_glitch);g++)
+			err |= bench_point(0.0,0.0,bench_glitch[g],count,seed);
+	}
+	return(err);
+}
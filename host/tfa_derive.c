@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+// Accuracy check of derived humidity quantities of TFA Dostmann 30.3215.02
+// receiver. Receiver computes dew point, absolute humidity and heat index
+// from fixed-point tables (derive.c), this tool evaluates the same code for
+// every reading it can get (temperature in 0.1 degC steps over tables range,
+// humidity 1-100 %) and compares it to the formulas in double precision
+// libm. For each quantity it reports max and rms error and the worst reading.
+// Exit status is nonzero if any error exceeds 0.1 (report resolution).
+//
+// Usage:
+//   tfa_derive
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <math.h>
+
+#include "derive.h"
+
+#define DERIVE_TOL 0.1 /* max allowed error [degC] or [g/m3] */
+
+// reference dew point [degC]
+static double ref_dew(double temp, double rh)
+{
+	double gamma = log(rh/100.0) + DER_B*temp/(DER_C + temp);
+	return(DER_C*gamma/(DER_B - gamma));
+}
+
+// reference absolute humidity [g/m3]
+static double ref_ah(double temp, double rh)
+{
+	return(6.112*exp(DER_B*temp/(DER_C + temp))*rh*2.1674/(273.15 + temp));
+}
+
+// reference heat index [degC]
+static double ref_hi(double temp, double rh)
+{
+	if(temp < 0.1*DER_HI_T_MIN || rh < DER_HI_RH_MIN)
+		return(temp);
+	return(-8.78469475556 + 1.61139411*temp + 2.33854883889*rh - 0.14611605*temp*rh - 0.012308094*temp*temp
+		- 0.0164248277778*rh*rh + 2.211732e-3*temp*temp*rh + 7.2546e-4*temp*rh*rh - 3.582e-6*temp*temp*rh*rh);
+}
+
+// error statistics of quantity
+typedef struct{
+	const char *name;
+	double max;
+	double sum2;
+	int temp; /* worst reading */
+	int rh;
+}TDeriveErr;
+
+static void derive_err(TDeriveErr *err, double value, double ref, int temp, int rh)
+{
+	double e = fabs(value - ref);
+	err->sum2 += e*e;
+	if(e > err->max)
+	{
+		err->max = e;
+		err->temp = temp;
+		err->rh = rh;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if(argc > 1)
+	{
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return(1);
+	}
+
+	TDeriveErr err[3] = {{"dew point [degC]",0,0,0,0},{"abs. humidity [g/m3]",0,0,0,0},{"heat index [degC]",0,0,0,0}};
+	unsigned count = 0;
+	for(int temp = DER_T_MIN*10;temp <= DER_T_MAX*10;temp++)
+	{
+		for(int rh = 1;rh <= 100;rh++)
+		{
+			derive_err(&err[0],0.1*derive_dew(temp,rh),ref_dew(0.1*temp,rh),temp,rh);
+			derive_err(&err[1],0.01*derive_ah(temp,rh),ref_ah(0.1*temp,rh),temp,rh);
+			derive_err(&err[2],0.1*derive_hi(temp,rh),ref_hi(0.1*temp,rh),temp,rh);
+			count++;
+		}
+	}
+
+	int fail = 0;
+	printf("quantity\tmax error\trms error\tworst t [degC]\tworst rh [%%]\n");
+	for(int k = 0;k < 3;k++)
+	{
+		printf("%s\t%.3f\t%.3f\t%.1f\t%d\n",err[k].name,err[k].max,sqrt(err[k].sum2/count),0.1*err[k].temp,err[k].rh);
+		fail |= err[k].max > DERIVE_TOL;
+	}
+	return(fail);
+}
@@ -0,0 +1,249 @@
+//-----------------------------------------------------------------------------
+// Synthetic TFA Dostmann 30.3215.02 transmission generator.
+// Generates slots with transmissions of random sensors (see synth.c) with
+// configurable imperfections and writes them as SPBS02 scope file, plain
+// int8 samples (for tfa_stream) or raw edge stream (for tfa_raw). Slots
+// are generated by multiple threads. Optional list of generated sensors
+// serves as reference for decoder testing.
+//
+// Usage:
+//   tfa_gen [options] output
+//     -o wave|i8|raw - output format (default wave = SPBS02 scope file)
+//     -n slots - number of slots (default 10)
+//     -f fs - sampling rate [Hz] (default 500000)
+//     -s sensors - transmitting sensors per slot (default 1)
+//     -O overlap - max start offset of sensors in slot [s] (default 0)
+//     -w width - pulse width [s] (default 0.5e-3)
+//     -j jitter - pulse and gap width jitter sigma [s] (default 0)
+//     -N noise - sample noise sigma [int8 bit] (default 0)
+//     -g rate - glitch rate [1/s] (default 0)
+//     -G width - max glitch width [s] (default 0.2e-3)
+//     -d drift - max sensor clock drift [ppm] (default 0)
+//     -S seed - random seed (default 1)
+//     -t threads - worker threads (default 4)
+//     -l file - write list of generated sensors (slot, t_start, report)
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "tfa_core.h"
+#include "owon.h"
+#include "synth.h"
+
+#define GEN_SLOTS_PER_THREAD 4 /* slots per thread in one batch */
+#define GEN_THREADS 64 /* max threads */
+
+#define GEN_WAVE 0 /* SPBS02 scope file */
+#define GEN_I8 1 /* plain int8 samples */
+#define GEN_RAW 2 /* receiver raw edge stream */
+
+// generator job
+typedef struct{
+	const TSynth *syn;
+	int format;
+	uint64_t seed; /* base seed */
+	uint64_t first; /* first slot index of batch */
+	size_t slots; /* slots in batch */
+	size_t stride; /* threads count */
+	size_t thread; /* this thread index */
+	uint8_t **data; /* slot output buffers */
+	size_t *cap; /* slot output buffers capacity [bytes] */
+	size_t *size; /* slot output sizes */
+	TSynthSlot *slot; /* generated slots (sensors) */
+	int error;
+}TGenJob;
+
+// generate slots of batch assigned to thread
+static void *gen_worker(void *arg)
+{
+	TGenJob *job = (TGenJob*)arg;
+	for(size_t k = job->thread;k < job->slots;k += job->stride)
+	{
+		uint64_t seed = job->seed*0x100000001B3ull + job->first + k;
+		TSynthSlot *slot = &job->slot[k];
+		if(synth_slot(job->syn,seed,slot))
+		{
+			job->error = 1;
+			continue;
+		}
+		if(job->format == GEN_RAW)
+		{
+			// raw stream size depends on edges count of slot, grow buffer if needed
+			size_t need = synth_raw_size(slot);
+			if(need > job->cap[k])
+			{
+				uint8_t *data = (uint8_t*)realloc((void*)job->data[k],need);
+				if(!data)
+				{
+					job->error = 1;
+					synth_slot_free(slot);
+					continue;
+				}
+				job->data[k] = data;
+				job->cap[k] = need;
+			}
+			job->size[k] = synth_raw(slot,job->data[k]);
+		}
+		else
+		{
+			synth_render(job->syn,seed,slot,(int8_t*)job->data[k]);
+			job->size[k] = synth_samples(job->syn);
+		}
+		synth_slot_free(slot);
+	}
+	return(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	TSynthCfg cfg;
+	synth_defaults(&cfg);
+	int format = GEN_WAVE;
+	uint64_t slots = 10;
+	uint64_t seed = 1;
+	size_t threads = 4;
+	const char *path = NULL;
+	const char *list_path = NULL;
+	int err = 0;
+	for(int k = 1;k < argc && !err;k++)
+	{
+		const char *opt = argv[k];
+		if(opt[0] != '-')
+		{
+			err = !!path;
+			path = opt;
+			continue;
+		}
+		if(k + 1 >= argc || opt[2])
+		{
+			err = 1;
+			break;
+		}
+		const char *val = argv[++k];
+		switch(opt[1])
+		{
+			case 'o': format = !strcmp(val,"wave") ? GEN_WAVE : (!strcmp(val,"i8") ? GEN_I8 : (!strcmp(val,"raw") ? GEN_RAW : -1)); err = format < 0; break;
+			case 'n': slots = strtoull(val,NULL,10); break;
+			case 'f': cfg.fs = atof(val); break;
+			case 's': cfg.sensors = atoi(val); break;
+			case 'O': cfg.overlap = atof(val); break;
+			case 'w': cfg.pulse = atof(val); break;
+			case 'j': cfg.jitter = atof(val); break;
+			case 'N': cfg.noise = atof(val); break;
+			case 'g': cfg.glitch_rate = atof(val); break;
+			case 'G': cfg.glitch_width = atof(val); break;
+			case 'd': cfg.drift = atof(val); break;
+			case 'S': seed = strtoull(val,NULL,10); break;
+			case 't': threads = (size_t)atoi(val); break;
+			case 'l': list_path = val; break;
+			default: err = 1;
+		}
+	}
+	if(err || !path || cfg.fs <= 0.0 || cfg.sensors < 1 || cfg.sensors > SYNTH_SENSORS || threads < 1 || threads > GEN_THREADS)
+	{
+		fprintf(stderr,"usage: %s [-o wave|i8|raw] [-n slots] [-f fs] [-s sensors] [-O overlap] [-w width] [-j jitter]\n"
+		               "       [-N noise] [-g rate] [-G width] [-d drift] [-S seed] [-t threads] [-l list] output\n",argv[0]);
+		return(1);
+	}
+
+	static TSynth syn;
+	synth_init(&syn,&cfg);
+	size_t samples = synth_samples(&syn);
+	if(format == GEN_WAVE && (double)samples*slots > 4294967295.0)
+	{
+		fprintf(stderr,"too many samples for SPBS02 file\n");
+		return(1);
+	}
+
+	FILE *fw = fopen(path,"wb");
+	FILE *fl = list_path ? fopen(list_path,"w") : NULL;
+	if(!fw || (list_path && !fl))
+	{
+		fprintf(stderr,"cannot create output\n");
+		return(1);
+	}
+	if(format == GEN_WAVE)
+		owon_write_head(fw,cfg.fs,(uint32_t)(samples*slots));
+
+	// batch buffers
+	size_t batch = threads*GEN_SLOTS_PER_THREAD;
+	uint8_t **data = (uint8_t**)calloc(batch,sizeof(uint8_t*));
+	size_t *cap = (size_t*)calloc(batch,sizeof(size_t));
+	size_t *size = (size_t*)calloc(batch,sizeof(size_t));
+	TSynthSlot *slot = (TSynthSlot*)calloc(batch,sizeof(TSynthSlot));
+	TGenJob job[GEN_THREADS];
+	pthread_t thr[GEN_THREADS];
+	for(size_t k = 0;data && cap && k < batch;k++)
+	{
+		// raw stream buffers are grown by workers to edges count of slot
+		cap[k] = (format == GEN_RAW) ? 4096 : samples;
+		if(!(data[k] = (uint8_t*)malloc(cap[k])))
+			err = 1;
+	}
+	if(!data || !cap || !size || !slot || err)
+	{
+		fprintf(stderr,"out of memory\n");
+		return(1);
+	}
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC,&t0);
+	uint64_t total = 0;
+	for(uint64_t first = 0;first < slots && !err;first += batch)
+	{
+		size_t count = (slots - first > batch) ? batch : (size_t)(slots - first);
+		for(size_t t = 0;t < threads;t++)
+		{
+			job[t] = (TGenJob){&syn,format,seed,first,count,threads,t,data,cap,size,slot,0};
+			pthread_create(&thr[t],NULL,gen_worker,(void*)&job[t]);
+		}
+		for(size_t t = 0;t < threads;t++)
+		{
+			pthread_join(thr[t],NULL);
+			err |= job[t].error;
+		}
+
+		// write slots in order
+		for(size_t k = 0;k < count && !err;k++)
+		{
+			err |= fwrite((void*)data[k],1,size[k],fw) != size[k];
+			total += size[k];
+			for(int s = 0;fl && s < slot[k].sensors;s++)
+			{
+				const TSynthSensor *sensor = &slot[k].sensor[s];
+				fprintf(fl,"%llu, %.6f, %2u, %u, %0.1f, %u, %u, %u\n",(unsigned long long)(first + k),(first + k)*syn.slot + sensor->t_start,
+					sensor->id,sensor->channel,0.1*sensor->temp,sensor->rh,SENSOR_IS_LOW_BATT(sensor->flags),SENSOR_IS_SYNC(sensor->flags));
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC,&t1);
+	double t = (t1.tv_sec - t0.tv_sec) + 1e-9*(t1.tv_nsec - t0.tv_nsec);
+
+	fclose(fw);
+	if(fl)
+		fclose(fl);
+	for(size_t k = 0;k < batch;k++)
+		free((void*)data[k]);
+	free((void*)data);
+	free((void*)cap);
+	free((void*)size);
+	free((void*)slot);
+	if(err)
+	{
+		fprintf(stderr,"generator failed\n");
+		return(1);
+	}
+	fprintf(stderr,"slots: %llu (%.3f s each), output: %.3f MB, %.1f MB/s\n",(unsigned long long)slots,syn.slot,1e-6*total,1e-6*total/t);
+	return(0);
+}
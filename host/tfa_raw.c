@@ -0,0 +1,75 @@
+//-----------------------------------------------------------------------------
+// Host decoder of raw edge stream of TFA Dostmann 30.3215.02 receiver.
+// Receiver streams durations of RX module output levels in TFA:RAW mode,
+// this tool decodes them using the same decoder core as the receiver and
+// prints sensor data in receiver's report format.
+//
+// Usage:
+//   tfa_raw [-n] [file]
+//     -n - report data without headers
+//     file - raw stream file or serial port (default stdin)
+//
+//   Example for serial port (receiver set to 19200bd):
+//     stty -F /dev/ttyUSB0 19200 raw -echo
+//     printf 'TFA:RAW 1\n' > /dev/ttyUSB0
+//     ./tfa_raw /dev/ttyUSB0
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+#include "report.h"
+
+// report decoded sensor
+static void on_sensor(const TSensor *sensor, void *user)
+{
+	report_sensor(stdout,sensor,*(int*)user);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	int head = 1;
+	const char *path = NULL;
+	for(int k = 1;k < argc;k++)
+	{
+		if(!strcmp(argv[k],"-n"))
+			head = 0;
+		else if(!path)
+			path = argv[k];
+		else
+		{
+			fprintf(stderr,"usage: %s [-n] [file]\n",argv[0]);
+			return(1);
+		}
+	}
+
+	FILE *fr = stdin;
+	if(path && !(fr = fopen(path,"rb")))
+	{
+		fprintf(stderr,"cannot open '%s'\n",path);
+		return(1);
+	}
+
+	TDec dec;
+	dec_init(&dec,on_sensor,(void*)&head);
+
+	uint8_t buf[256];
+	size_t size;
+	while((size = fread((void*)buf,1,sizeof(buf),fr)) > 0)
+		dec_raw(&dec,buf,size);
+
+	fprintf(stderr,"transmissions: %u, packets: %u, lost edge markers: %u\n",dec.transmissions,dec.packets,dec.lost);
+	if(fr != stdin)
+		fclose(fr);
+	return(0);
+}
@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+// Host decoder of TFA Dostmann 30.3215.02 transmissions captured by scope.
+// Reads OWON SPBS02 BIN files (see ../data) and decodes raw int8 samples
+// by streaming decoder (SIMD threshold slicer with threshold tracking and
+// the same decoder core as the AVR receiver).
+// Prints sensor data in receiver's report format.
+//
+// Usage:
+//   tfa_scope [-n] file.bin [file.bin ...]
+//     -n - report data without headers
+//   tfa_scope -b [MB] file.bin
+//     benchmark slicer kernels on given file (default 1024 MB of samples)
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tfa_core.h"
+#include "dec.h"
+#include "report.h"
+#include "owon.h"
+#include "slicer.h"
+#include "stream.h"
+
+
+// report decoded sensor
+static void on_sensor(const TSensor *sensor, void *user)
+{
+	report_sensor(stdout,sensor,*(int*)user);
+}
+
+// decode scope file
+static int scope_decode(const char *path, int head)
+{
+	TOwon owon;
+	if(owon_read(&owon,path))
+	{
+		fprintf(stderr,"cannot read '%s'\n",path);
+		return(1);
+	}
+	printf("%s:\n",path);
+
+	// streaming decoder (single pass threshold tracking instead of min/max of whole record as tfa.m)
+	static TStream st;
+	stream_init(&st,owon.fs,on_sensor,(void*)&head);
+	stream_i8(&st,owon.u,owon.count);
+	stream_flush(&st);
+
+	owon_free(&owon);
+	return(0);
+}
+
+// benchmark slicer kernels
+static int scope_bench(const char *path, double mbytes)
+{
+	TOwon owon;
+	if(owon_read(&owon,path) || !owon.count)
+	{
+		fprintf(stderr,"cannot read '%s'\n",path);
+		return(1);
+	}
+	uint32_t *edges = (uint32_t*)malloc(owon.count*sizeof(uint32_t));
+	size_t loops = (size_t)(mbytes*1e6/owon.count) + 1;
+	static const char *isa[3] = {"scalar","sse2","avx2"};
+	for(int m = 0;m < 3;m++)
+	{
+		if(slicer_use(isa[m]))
+			continue;
+		TSlicer sl;
+		slicer_init(&sl,0,0);
+		size_t count = 0;
+		clock_t t0 = clock();
+		for(size_t k = 0;k < loops;k++)
+			count += slicer_i8(&sl,owon.u,owon.count,edges);
+		double t = (double)(clock() - t0)/CLOCKS_PER_SEC;
+		printf("%-6s: %8.3f GB/s (%zu edges)\n",isa[m],1e-9*loops*owon.count/t,count);
+
+		// with threshold tracking
+		TSlicerTrack tr;
+		slicer_track_init(&tr,11,STREAM_SWING);
+		count = 0;
+		t0 = clock();
+		for(size_t k = 0;k < loops;k++)
+			count += slicer_track_i8(&sl,&tr,owon.u,owon.count,edges);
+		t = (double)(clock() - t0)/CLOCKS_PER_SEC;
+		printf("%-6s: %8.3f GB/s (%zu edges, threshold tracking)\n",isa[m],1e-9*loops*owon.count/t,count);
+	}
+	free((void*)edges);
+	owon_free(&owon);
+	return(0);
+}
+
+int main(int argc, char **argv)
+{
+	int head = 1;
+	int files = 0;
+	for(int k = 1;k < argc;k++)
+	{
+		if(!strcmp(argv[k],"-n"))
+			head = 0;
+		else if(!strcmp(argv[k],"-b"))
+		{
+			double mbytes = 1024.0;
+			if(k + 2 < argc)
+				mbytes = atof(argv[++k]);
+			if(k + 1 >= argc)
+				break;
+			return(scope_bench(argv[k+1],mbytes));
+		}
+		else
+		{
+			scope_decode(argv[k],head);
+			files++;
+		}
+	}
+	if(!files)
+	{
+		fprintf(stderr,"usage: %s [-n] file.bin [file.bin ...]\n       %s -b [MB] file.bin\n",argv[0],argv[0]);
+		return(1);
+	}
+	return(0);
+}
@@ -0,0 +1,105 @@
+//-----------------------------------------------------------------------------
+// Continuous decoder of TFA Dostmann 30.3215.02 from sample stream.
+// Reads demodulated ASK samples (RX module output sampled by ADC, envelope
+// from software radio, ...) from file or pipe in chunks and decodes them
+// by streaming decoder in constant memory. Prints sensor data in receiver's
+// report format as soon as transmission is decoded.
+//
+// Usage:
+//   tfa_stream [-n] [-f fs] [-t i8|i16|f32] [-s full_scale] [file]
+//     -n - report data without headers
+//     -f - sampling rate [Hz] (default 500000)
+//     -t - sample format: int8, int16 little endian or float32 (default i8)
+//     -s - full scale of samples (int16 default 32768, e.g. 2048 for 12-bit ADC,
+//          float32 default 1.0)
+//     file - samples file (default stdin)
+//
+// (c) 2023, Stanislav Maslan, s.maslan@seznam.cz
+// url: https://github.com/smaslan/TFA-30321502-decoder
+// V1.0, 2023-07-27, initial version
+//
+// The code and all its part are distributed under MIT license
+// https://opensource.org/licenses/MIT.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tfa_core.h"
+#include "report.h"
+#include "stream.h"
+
+#define READ_CHUNK 16384 /* read chunk [B] */
+
+// report decoded sensor
+static void on_sensor(const TSensor *sensor, void *user)
+{
+	report_sensor(stdout,sensor,*(int*)user);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	int head = 1;
+	double fs = 500e3;
+	const char *type = "i8";
+	const char *scale = NULL;
+	const char *path = NULL;
+	for(int k = 1;k < argc;k++)
+	{
+		if(!strcmp(argv[k],"-n"))
+			head = 0;
+		else if(!strcmp(argv[k],"-f") && k + 1 < argc)
+			fs = atof(argv[++k]);
+		else if(!strcmp(argv[k],"-t") && k + 1 < argc)
+			type = argv[++k];
+		else if(!strcmp(argv[k],"-s") && k + 1 < argc)
+			scale = argv[++k];
+		else if(argv[k][0] != '-' && !path)
+			path = argv[k];
+		else
+			path = NULL, fs = 0.0;
+	}
+	size_t sample = !strcmp(type,"i8") ? 1 : (!strcmp(type,"i16") ? 2 : (!strcmp(type,"f32") ? 4 : 0));
+	float full_scale = scale ? (float)atof(scale) : ((sample == 2) ? 32768.0f : 1.0f);
+	if(fs <= 0.0 || !sample || full_scale <= 0.0f || (sample == 2 && (full_scale < 1.0f || full_scale > 32768.0f)))
+	{
+		fprintf(stderr,"usage: %s [-n] [-f fs] [-t i8|i16|f32] [-s full_scale] [file]\n",argv[0]);
+		return(1);
+	}
+
+	FILE *fr = stdin;
+	if(path && !(fr = fopen(path,"rb")))
+	{
+		fprintf(stderr,"cannot open '%s'\n",path);
+		return(1);
+	}
+
+	static TStream st;
+	stream_init(&st,fs,on_sensor,(void*)&head);
+
+	// read whole samples only, keep partial sample for next read
+	static union{uint8_t u8[READ_CHUNK]; int8_t i8[READ_CHUNK]; int16_t i16[READ_CHUNK/2]; float f32[READ_CHUNK/4];} buf;
+	size_t fill = 0;
+	size_t size;
+	while((size = fread((void*)&buf.u8[fill],1,READ_CHUNK - fill,fr)) > 0)
+	{
+		fill += size;
+		size_t n = fill/sample;
+		if(sample == 1)
+			stream_i8(&st,buf.i8,n);
+		else if(sample == 2)
+			stream_i16(&st,buf.i16,n,(int32_t)full_scale);
+		else
+			stream_f32(&st,buf.f32,n,full_scale);
+		memmove((void*)buf.u8,(void*)&buf.u8[n*sample],fill - n*sample);
+		fill -= n*sample;
+	}
+	stream_flush(&st);
+
+	fprintf(stderr,"transmissions: %u, packets: %u\n",st.dec.transmissions,st.dec.packets);
+	if(fr != stdin)
+		fclose(fr);
+	return(0);
+}